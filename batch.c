@@ -0,0 +1,349 @@
+#include "batch.h"
+#include "config.h"
+#include "filters.h"
+#include "signal_processing.h"
+#include "trigger.h"
+#include "drift_analysis.h"
+#include "io.h"
+#include "pipeline.h"
+#include "waveform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <omp.h>
+
+#define BATCH_MAX_JOBS 100000
+
+extern const char *building_keys[];
+extern const char *damage_keys[];
+
+static const char *status_names[] = {
+    "-", "ALLARME", "no allarme", "no trigger", "ERRORE"
+};
+
+int parse_table_key(const char *token, const char **keys, int n_keys) {
+    char *end;
+    long v = strtol(token, &end, 10);
+    if (*end == '\0') return (v >= 0 && v < n_keys) ? (int)v : -1;
+    for (int i = 0; i < n_keys; i++) {
+        if (strcasecmp(token, keys[i]) == 0) return i;
+    }
+    return -1;
+}
+
+int read_batch_manifest(const char *filename, BatchJob **jobs) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+        printf("ERRORE: Impossibile aprire %s\n", filename);
+        return -1;
+    }
+    
+    int capacity = 64, count = 0, line_no = 0, errors = 0;
+    BatchJob *list = (BatchJob*)malloc(capacity * sizeof(BatchJob));
+    char line[1024];
+    
+    while (list && fgets(line, sizeof(line), fp)) {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+    
+        char building[64], damage[64], unit[16];
+        BatchJob job;
+        memset(&job, 0, sizeof(job));
+        int fields = sscanf(line, "%63s %63s %f %d %15s %255s %255s",
+                            building, damage, &job.height, &job.fs, unit,
+                            job.file_top, job.file_base);
+        if (fields <= 0) continue;
+    
+        int type = (fields == 7) ? parse_table_key(building, building_keys, 6) : -1;
+        int state = (fields == 7) ? parse_table_key(damage, damage_keys, 3) : -1;
+        int unit_ok = strcmp(unit, "g") == 0 || strcmp(unit, "ms2") == 0;
+        if (type < 0 || state < 0 || !unit_ok || job.height <= 0 ||
+            job.height > 200 || job.fs < 10 || job.fs > 1000) {
+            printf("⚠ %s riga %d non valida, ignorata\n", filename, line_no);
+            errors++;
+            continue;
+        }
+        if (count >= BATCH_MAX_JOBS) {
+            printf("⚠ %s: oltre %d record, i successivi sono ignorati\n",
+                   filename, BATCH_MAX_JOBS);
+            break;
+        }
+    
+        job.line = line_no;
+        job.type = (BuildingType)type;
+        job.state = (DamageState)state;
+        job.input_is_g = (strcmp(unit, "g") == 0);
+        job.status = BATCH_PENDING;
+        job.trigger_idx = -1;
+    
+        if (count == capacity) {
+            capacity *= 2;
+            BatchJob *grown = (BatchJob*)realloc(list, capacity * sizeof(BatchJob));
+            if (!grown) {
+                free(list);
+                list = NULL;
+                break;
+            }
+            list = grown;
+        }
+        list[count++] = job;
+    }
+    fclose(fp);
+    
+    if (!list) {
+        printf("ERRORE: Memoria insufficiente per il manifest\n");
+        return -1;
+    }
+    if (errors > 0) {
+        printf("⚠ %d righe scartate dal manifest\n", errors);
+    }
+    *jobs = list;
+    return count;
+}
+
+// Stessa pipeline della modalità interattiva, senza file di output
+static void process_job(BatchJob *job, FilterConfig *filter,
+                        SignalData *top, SignalData *base,
+                        const TriggerBankParams *bank) {
+    WaveformFile wf_top = {0}, wf_base = {0};
+    float unit_conv = job->input_is_g ? G_TO_MS2 : 1.0f;
+    double t0 = omp_get_wtime();
+    
+    job->status = BATCH_ERROR;
+    for (int d = 0; d < DETECTOR_COUNT; d++) job->bank_pick[d] = -1;
+    
+    int n_top = load_channel(job->file_top, 0, top, &wf_top, unit_conv, job->fs);
+    int base_channel = (strcmp(job->file_base, job->file_top) == 0) ? 1 : 0;
+    int n_base = (n_top < 0) ? -1 : load_channel(job->file_base, base_channel,
+                                                 base, &wf_base, unit_conv,
+                                                 job->fs);
+    int n = (n_top < n_base) ? n_top : n_base;
+    job->n_samples = (n > 0) ? n : 0;
+    
+    // Serve almeno il warm-up FIR più una finestra LTA
+    int lta_len = (int)(LTA_WINDOW_S * job->fs);
+    if (n <= filter->fir_warmup + lta_len) {
+        if (n >= 0) {
+            printf("⚠ Riga %d: record troppo corto (%d campioni)\n",
+                   job->line, n);
+        }
+        goto done;
+    }
+    top->n_samples = base->n_samples = n;
+    
+    TriggerParams trigger;
+    init_trigger_params(&trigger, STA_WINDOW_S, LTA_WINDOW_S);
+    
+    AlarmThreshold threshold = {job->type, job->state, 0.0f, 0.0f};
+    get_alarm_thresholds(job->type, job->state, &threshold.drift_limit,
+                         &threshold.prob_threshold);
+    
+    // Nessun output per campione: pipeline fusa senza array intermedi
+    // (il banco rivelatori legge acc_fir completo: pipeline a stadi)
+    if (!bank && fused_pipeline_supported(filter, n)) {
+        if (!run_fused_pipeline(top, base, n, filter, &trigger, PTM_WINDOW_S,
+                                job->height, &threshold, &job->results,
+                                NULL, NULL, 0)) {
+            job->status = BATCH_NO_TRIGGER;
+            goto done;
+        }
+    } else {
+        apply_highpass_filter(top->acc, top->acc_hp, n, filter->hp_a,
+                              filter->hp_b * top->acc_scale);
+        apply_gaussian_smoothing(top->acc_hp, top->acc_fir, n, filter);
+        apply_highpass_filter(base->acc, base->acc_hp, n, filter->hp_a,
+                              filter->hp_b * base->acc_scale);
+        
+        if (bank) {
+            TriggerBankResult bank_result;
+            TriggerBankParams params = *bank;
+            params.threshold[DETECTOR_STA_LTA] = trigger.threshold;
+            if (run_trigger_bank(top->acc_fir, n, filter, &params,
+                                 &bank_result, 0)) {
+                for (int d = 0; d < DETECTOR_COUNT; d++) {
+                    job->bank_pick[d] = bank_result.pick_idx[d];
+                }
+            }
+        }
+        
+        if (!find_trigger(top->acc_fir, n, &trigger, filter)) {
+            job->status = BATCH_NO_TRIGGER;
+            goto done;
+        }
+        perform_drift_analysis(top, base, &trigger, filter, PTM_WINDOW_S,
+                               job->height, &threshold, &job->results, NULL,
+                               NULL);
+    }
+    job->trigger_idx = trigger.trigger_idx;
+    job->status = job->results.alarm_triggered ? BATCH_ALARM : BATCH_NO_ALARM;
+
+done:
+    waveform_close(&wf_top);
+    waveform_close(&wf_base);
+    job->elapsed_s = omp_get_wtime() - t0;
+}
+
+static void print_summary(const BatchJob *jobs, int n_jobs) {
+    printf("\n========== RIEPILOGO BATCH ==========\n");
+    printf("%5s  %-17s %-9s %5s %8s %9s  %-10s %8s %9s %8s %7s\n",
+           "riga", "edificio", "danno", "fs", "campioni", "trigger_s",
+           "esito", "t_all_s", "PGD_m", "drift", "P_%");
+    for (int j = 0; j < n_jobs; j++) {
+        const BatchJob *b = &jobs[j];
+        printf("%5d  %-17s %-9s %5d %8d ", b->line, building_keys[b->type],
+               damage_keys[b->state], b->fs, b->n_samples);
+        if (b->trigger_idx >= 0) {
+            printf("%9.3f", b->trigger_idx / (float)b->fs);
+        } else {
+            printf("%9s", "-");
+        }
+        if (b->status != BATCH_ALARM && b->status != BATCH_NO_ALARM) {
+            printf("  %s\n", status_names[b->status]);
+            continue;
+        }
+        printf("  %-10s", status_names[b->status]);
+        if (b->status == BATCH_ALARM) {
+            printf(" %8.3f", (b->results.alarm_idx - b->trigger_idx) /
+                             (float)b->fs);
+        } else {
+            printf(" %8s", "-");
+        }
+        printf(" %9.5f %8.2f %7.2f\n", b->results.pgd_base,
+               b->results.max_drift_norm * 1000,
+               b->results.max_prob * 100.0f);
+    }
+}
+
+static int write_summary_csv(const char *filename, const BatchJob *jobs,
+                             int n_jobs, int with_bank) {
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        printf("ERRORE: Impossibile creare %s\n", filename);
+        return 0;
+    }
+    fprintf(fp, "# Riga, Edificio, Danno, Altezza(m), fs, File_TOP, File_BASE, "
+                "Campioni, Esito, Trigger(s), Allarme_dopo_trigger(s), "
+                "PGD_base(m), Drift_norm(mm/m), Prob(%%), Tempo(ms)");
+    if (with_bank) {
+        for (int d = 0; d < DETECTOR_COUNT; d++) {
+            fprintf(fp, ", Pick_%s(s)", detector_name((DetectorType)d));
+        }
+    }
+    fprintf(fp, "\n");
+    for (int j = 0; j < n_jobs; j++) {
+        const BatchJob *b = &jobs[j];
+        int analysed = (b->status == BATCH_ALARM || b->status == BATCH_NO_ALARM);
+        fprintf(fp, "%d, %s, %s, %.1f, %d, %s, %s, %d, %s, %.3f, %.3f, "
+                    "%.6e, %.4f, %.2f, %.2f",
+                b->line, building_keys[b->type], damage_keys[b->state],
+                b->height, b->fs, b->file_top, b->file_base, b->n_samples,
+                status_names[b->status],
+                b->trigger_idx >= 0 ? b->trigger_idx / (float)b->fs : -1.0f,
+                b->status == BATCH_ALARM ?
+                    (b->results.alarm_idx - b->trigger_idx) / (float)b->fs : -1.0f,
+                analysed ? b->results.pgd_base : 0.0f,
+                analysed ? b->results.max_drift_norm * 1000 : 0.0f,
+                analysed ? b->results.max_prob * 100.0f : 0.0f,
+                b->elapsed_s * 1000.0);
+        if (with_bank) {
+            for (int d = 0; d < DETECTOR_COUNT; d++) {
+                fprintf(fp, ", %.3f", b->bank_pick[d] >= 0 ?
+                        b->bank_pick[d] / (float)b->fs : -1.0f);
+            }
+        }
+        fprintf(fp, "\n");
+    }
+    return fclose(fp) == 0;
+}
+
+int run_batch(const char *manifest, const char *summary_file, FirMode mode,
+              const TriggerBankParams *bank) {
+    BatchJob *jobs = NULL;
+    int n_jobs = read_batch_manifest(manifest, &jobs);
+    if (n_jobs < 0) return 0;
+    if (n_jobs == 0) {
+        printf("⚠ Nessun record nel manifest %s\n", manifest);
+        free(jobs);
+        return 1;
+    }
+    
+    // Una configurazione filtri per frequenza, condivisa in sola lettura
+    int n_threads = omp_get_max_threads();
+    int *fs_list = (int*)malloc(n_jobs * sizeof(int));
+    int *filter_idx = (int*)malloc(n_jobs * sizeof(int));
+    FilterConfig *filters = (FilterConfig*)malloc(n_jobs * sizeof(FilterConfig));
+    SignalData **pool = (SignalData**)calloc(2 * n_threads, sizeof(SignalData*));
+    int n_filters = 0;
+    if (!fs_list || !filter_idx || !filters || !pool) {
+        printf("ERRORE: Memoria insufficiente per il batch\n");
+        free(fs_list);
+        free(filter_idx);
+        free(filters);
+        free(pool);
+        free(jobs);
+        return 0;
+    }
+    for (int j = 0; j < n_jobs; j++) {
+        int f = 0;
+        while (f < n_filters && fs_list[f] != jobs[j].fs) f++;
+        if (f == n_filters) {
+            fs_list[f] = jobs[j].fs;
+            init_filter_config(&filters[f], jobs[j].fs);
+            if (mode == FIR_MODE_RECURSIVE) set_fir_mode(&filters[f], mode);
+            n_filters++;
+        }
+        filter_idx[j] = f;
+    }
+    
+    printf("Batch: %d record, %d frequenze, %d thread\n",
+           n_jobs, n_filters, n_threads);
+    
+    // Pool limitato: una coppia TOP/BASE per thread, riusata tra i record
+    // (ogni arena cresce fino al record più lungo visto dal thread)
+    long total_samples = 0;
+    double t0 = omp_get_wtime();
+    
+    #pragma omp parallel reduction(+:total_samples)
+    {
+        int tid = omp_get_thread_num();
+        SignalData *top = create_signal_data(0);
+        SignalData *base = create_signal_data(0);
+        pool[2 * tid] = top;
+        pool[2 * tid + 1] = base;
+    
+        #pragma omp for schedule(dynamic, 1)
+        for (int j = 0; j < n_jobs; j++) {
+            if (!top || !base) continue;
+            process_job(&jobs[j], &filters[filter_idx[j]], top, base, bank);
+            total_samples += jobs[j].n_samples;
+        }
+    }
+    double elapsed = omp_get_wtime() - t0;
+    
+    print_summary(jobs, n_jobs);
+    
+    int counts[BATCH_ERROR + 1] = {0};
+    for (int j = 0; j < n_jobs; j++) counts[jobs[j].status]++;
+    printf("\nAllarmi: %d, senza allarme: %d, senza trigger: %d, errori: %d\n",
+           counts[BATCH_ALARM], counts[BATCH_NO_ALARM],
+           counts[BATCH_NO_TRIGGER], counts[BATCH_ERROR] + counts[BATCH_PENDING]);
+    printf("Tempo totale: %.3f s, %.1f record/s, %.2f Mcampioni/s\n",
+           elapsed, n_jobs / elapsed, 2.0 * total_samples / elapsed / 1e6);
+    
+    int ok = 1;
+    if (summary_file) {
+        ok = write_summary_csv(summary_file, jobs, n_jobs, bank != NULL);
+        if (ok) printf("✓ Riepilogo: %s\n", summary_file);
+    }
+    
+    for (int t = 0; t < 2 * n_threads; t++) free_signal_data(pool[t]);
+    free(pool);
+    for (int f = 0; f < n_filters; f++) cleanup_filter_config(&filters[f]);
+    free(filters);
+    free(fs_list);
+    free(filter_idx);
+    free(jobs);
+    return ok;
+}
@@ -0,0 +1,49 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "types.h"
+#include "trigger.h"
+
+typedef enum {
+    BATCH_PENDING,
+    BATCH_ALARM,          // Trigger e allarme
+    BATCH_NO_ALARM,       // Trigger senza allarme
+    BATCH_NO_TRIGGER,     // STA/LTA sempre sotto soglia
+    BATCH_ERROR           // File illeggibile o record troppo corto
+} BatchStatus;
+
+// Un record del catalogo (una riga del manifest)
+typedef struct {
+    int line;                 // Riga nel manifest
+    BuildingType type;
+    DamageState state;
+    float height;
+    int fs;
+    int input_is_g;
+    char file_top[256];
+    char file_base[256];
+    
+    BatchStatus status;
+    int n_samples;
+    int trigger_idx;
+    AnalysisResults results;
+    int bank_pick[DETECTOR_COUNT];    // Pick del banco rivelatori, -1 = nessuno
+    double elapsed_s;         // Tempo di elaborazione del record
+} BatchJob;
+
+// Indice numerico o nome (senza distinzione maiuscole), -1 se non valido
+int parse_table_key(const char *token, const char **keys, int n_keys);
+
+// Legge il manifest: una riga per record,
+//   edificio danno altezza fs unità file_top file_base
+// edificio/danno come indice del menu o nome (es. RC_LOW_RISE EXTENSIVE),
+// unità g o ms2; righe vuote e commenti (#) ignorati
+int read_batch_manifest(const char *filename, BatchJob **jobs);
+
+// Elabora tutti i record in parallelo e stampa la tabella riassuntiva;
+// summary_file (opzionale) riceve la stessa tabella in CSV. Con bank
+// ogni record passa anche dal banco rivelatori (pick nel CSV)
+int run_batch(const char *manifest, const char *summary_file, FirMode mode,
+              const TriggerBankParams *bank);
+
+#endif
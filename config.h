@@ -4,16 +4,58 @@
 #define MAX_SAMPLES 500000
 #define MAX_KERNEL 400
 
+// Finestre trigger e monitoraggio (s)
+#define STA_WINDOW_S 0.5f          // Short Term Average
+#define LTA_WINDOW_S 6.0f          // Long Term Average
+#define PTM_WINDOW_S 10.0f         // Post-Trigger Monitoring
+#define STA_LTA_THRESHOLD 4.0f     // Soglia del trigger STA/LTA
+#define STREAM_MAX_LTA_S 60.0f     // LTA massimo impostabile a caldo (streaming)
+
+// Banco di rivelatori (solo analisi, il trigger resta lo STA/LTA classico)
+#define KURTOSIS_WINDOW_S 1.0f     // Finestra kurtosis (s)
+#define RECURSIVE_THRESHOLD 6.0f   // STA/LTA ricorsivo sull'energia
+#define Z_DETECT_THRESHOLD 6.0f    // Z-detector (deviazioni standard)
+#define KURTOSIS_THRESHOLD 8.0f    // Kurtosis in eccesso
+
+// Blocco di uscite del FIR diretto (multiplo di 64, come i registri SIMD);
+// è anche la dimensione dei blocchi della pipeline fusa
+#define FIR_DIRECT_CHUNK 4096
+
+// Convoluzione FIR nel dominio della frequenza (overlap-save)
+#define FIR_FFT_MIN_TAPS 64        // Sotto questa lunghezza sempre diretto
+#define FIR_FFT_MAX_BLOCK 65536    // Lunghezza massima blocco FFT
+
+// Potatura kernel gaussiano: frazione massima di energia scartata
+#define FIR_PRUNE_TOL 1e-10f
+
+// Decimazione polifase davanti alla pipeline (--decimate fs)
+#define DECIM_TAPS_PER_PHASE 28    // Taps anti-alias per fase (pari: ritardo intero)
+#define DECIM_PASSBAND 0.4f        // Banda passante garantita (frazione di fs decimata)
+#define DECIM_MIN_FS 50            // Frequenza decimata minima (Hz)
+#define DECIM_BLOCK 4096           // Uscite decimate per blocco/thread
+#define DECIM_DRIFT_TOL 0.01f      // Scarto max del drift post-trigger vs piena frequenza
+
+// Scan parallela dell'HP (record lunghi)
+#define SCAN_PARALLEL_MIN 262144   // Campioni minimi per la scan parallela
+#define SCAN_MIN_BLOCK 65536       // Campioni minimi per blocco/thread
+#define SCAN_DECAY_EPS 1e-12       // Fine correzione quando a^k < eps
+
 // Configurazione edificio
 extern const float BUILDING_HEIGHT_M;
 extern const int INPUT_UNIT_IS_G;
 
+// Livello messaggi: 0 = solo avvisi ed errori (modalità batch), 1 = normale
+extern int verbosity;
+
+// Messaggi informativi, soppressi con verbosity = 0
+#define LOG_INFO(...) do { if (verbosity > 0) printf(__VA_ARGS__); } while (0)
+
 // Costanti fisiche
 extern const float G_TO_MS2;
 
-// Parametri regressione
-extern const float REG_INTERCEPT;
-extern const float REG_SLOPE;
-extern const float PRED_STD_DEV_LOG10;
+// Parametri regressione (riscritti solo dal demone, tra due campioni)
+extern float REG_INTERCEPT;
+extern float REG_SLOPE;
+extern float PRED_STD_DEV_LOG10;
 
 #endif
\ No newline at end of file
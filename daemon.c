@@ -0,0 +1,401 @@
+#include "daemon.h"
+#include "config.h"
+#include "filters.h"
+#include "trigger.h"
+#include "drift_analysis.h"
+#include "stream.h"
+#include "live.h"
+#include "batch.h"
+#include "io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <signal.h>
+#include <unistd.h>
+
+extern AlarmThreshold thresholds[];
+extern const int NUM_THRESHOLDS;
+extern const char *building_keys[];
+extern const char *damage_keys[];
+
+static volatile sig_atomic_t reload_requested = 0;
+
+static void on_sighup(int sig) {
+    (void)sig;
+    reload_requested = 1;
+}
+
+// Stato del demone condiviso con le callback del server
+typedef struct {
+    const char *filename;
+    DaemonConfig compiled;    // Valori compilati: base di ogni lettura
+    DaemonConfig cfg;         // Configurazione in uso
+    AlarmThreshold threshold; // Soglia del profilo attivo
+    LivePublisher *live;
+    float dt;
+    AnalysisResults last;
+    int n_events;
+    int n_reloads;
+} DaemonContext;
+
+// Configurazione con i valori compilati (tabella e regressione di main.c)
+static void compiled_defaults(DaemonConfig *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->proto = INGEST_UDP;
+    cfg->sta_s = STA_WINDOW_S;
+    cfg->lta_s = LTA_WINDOW_S;
+    cfg->ptm_s = PTM_WINDOW_S;
+    cfg->trigger_threshold = STA_LTA_THRESHOLD;
+    cfg->reg_intercept = REG_INTERCEPT;
+    cfg->reg_slope = REG_SLOPE;
+    cfg->reg_sigma = PRED_STD_DEV_LOG10;
+    cfg->n_table = NUM_THRESHOLDS < DAEMON_MAX_THRESHOLDS ?
+                   NUM_THRESHOLDS : DAEMON_MAX_THRESHOLDS;
+    memcpy(cfg->table, thresholds, cfg->n_table * sizeof(AlarmThreshold));
+    cfg->active = -1;
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+static int parse_float(const char *value, float *out) {
+    char *end;
+    float v = strtof(value, &end);
+    if (end == value || *trim(end) != '\0') return 0;
+    *out = v;
+    return 1;
+}
+
+static int parse_int(const char *value, int lo, int hi, int *out) {
+    char *end;
+    long v = strtol(value, &end, 10);
+    if (end == value || *trim(end) != '\0' || v < lo || v > hi) return 0;
+    *out = (int)v;
+    return 1;
+}
+
+// Una voce "chiave = valore"; ritorna 0 se non valida
+static int parse_entry(DaemonConfig *cfg, const char *key, char *value,
+                       char *active_name, size_t active_len) {
+    if (strcmp(key, "proto") == 0) {
+        if (strcmp(value, "udp") == 0) cfg->proto = INGEST_UDP;
+        else if (strcmp(value, "tcp") == 0) cfg->proto = INGEST_TCP;
+        else return 0;
+        return 1;
+    }
+    if (strcmp(key, "porta") == 0) return parse_int(value, 1, 65535, &cfg->port);
+    if (strcmp(key, "stazione") == 0) return parse_int(value, 0, 65535, &cfg->station);
+    if (strcmp(key, "fs") == 0) return parse_int(value, 10, 1000, &cfg->fs);
+    if (strcmp(key, "live") == 0) {
+        snprintf(cfg->live, sizeof(cfg->live), "%s", value);
+        return 1;
+    }
+    if (strcmp(key, "sta") == 0) return parse_float(value, &cfg->sta_s) && cfg->sta_s > 0.0f;
+    if (strcmp(key, "lta") == 0) return parse_float(value, &cfg->lta_s) && cfg->lta_s > 0.0f;
+    if (strcmp(key, "ptm") == 0) return parse_float(value, &cfg->ptm_s) && cfg->ptm_s > 0.0f;
+    if (strcmp(key, "trigger") == 0) {
+        return parse_float(value, &cfg->trigger_threshold) &&
+               cfg->trigger_threshold > 1.0f;
+    }
+    if (strcmp(key, "reg_intercept") == 0) return parse_float(value, &cfg->reg_intercept);
+    if (strcmp(key, "reg_slope") == 0) {
+        return parse_float(value, &cfg->reg_slope) && cfg->reg_slope > 0.0f;
+    }
+    if (strcmp(key, "reg_sigma") == 0) {
+        return parse_float(value, &cfg->reg_sigma) && cfg->reg_sigma > 0.0f;
+    }
+    if (strcmp(key, "soglia") == 0) {
+        char building[64], damage[64], extra[2];
+        float limit, prob;
+        if (sscanf(value, "%63s %63s %f %f %1s", building, damage, &limit,
+                   &prob, extra) != 4) {
+            return 0;
+        }
+        int type = parse_table_key(building, building_keys, 6);
+        int state = parse_table_key(damage, damage_keys, 3);
+        if (type < 0 || state < 0 || limit <= 0.0f || prob <= 0.0f || prob >= 100.0f) {
+            return 0;
+        }
+        for (int i = 0; i < cfg->n_table; i++) {
+            if ((int)cfg->table[i].type == type && (int)cfg->table[i].state == state) {
+                cfg->table[i].drift_limit = limit;
+                cfg->table[i].prob_threshold = prob;
+                return 1;
+            }
+        }
+        return 0;
+    }
+    if (strcmp(key, "profilo") == 0) {
+        BuildingProfile p;
+        char building[64], damage[64], extra[2];
+        if (sscanf(value, "%31s %63s %63s %f %1s", p.name, building, damage,
+                   &p.height, extra) != 4) {
+            return 0;
+        }
+        int type = parse_table_key(building, building_keys, 6);
+        int state = parse_table_key(damage, damage_keys, 3);
+        if (type < 0 || state < 0 || p.height <= 0.0f || p.height > 200.0f) return 0;
+        p.type = (BuildingType)type;
+        p.state = (DamageState)state;
+        // Stesso nome: l'ultima definizione vale
+        int k = 0;
+        while (k < cfg->n_profiles && strcmp(cfg->profiles[k].name, p.name) != 0) k++;
+        if (k == DAEMON_MAX_PROFILES) return 0;
+        cfg->profiles[k] = p;
+        if (k == cfg->n_profiles) cfg->n_profiles++;
+        return 1;
+    }
+    if (strcmp(key, "attivo") == 0) {
+        snprintf(active_name, active_len, "%s", value);
+        return 1;
+    }
+    return 0;
+}
+
+int daemon_config_load(const char *filename, const DaemonConfig *base,
+                       DaemonConfig *cfg) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+        printf("❌ ERRORE: Impossibile aprire %s\n", filename);
+        return 0;
+    }
+
+    *cfg = *base;
+    char active_name[32] = "";
+    char line[512];
+    int line_no = 0;
+    int ok = 1;
+
+    while (ok && fgets(line, sizeof(line), fp)) {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *eq = strchr(line, '=');
+        if (!eq) {
+            if (*trim(line) == '\0') continue;
+            printf("❌ %s riga %d: manca '='\n", filename, line_no);
+            ok = 0;
+            break;
+        }
+        *eq = '\0';
+        char *key = trim(line);
+        char *value = trim(eq + 1);
+        if (!parse_entry(cfg, key, value, active_name, sizeof(active_name))) {
+            printf("❌ %s riga %d: voce '%s' non valida\n", filename, line_no, key);
+            ok = 0;
+        }
+    }
+    fclose(fp);
+    if (!ok) return 0;
+
+    if (cfg->port == 0 || cfg->fs == 0 || cfg->n_profiles == 0) {
+        printf("❌ %s: porta, fs e almeno un profilo sono obbligatori\n", filename);
+        return 0;
+    }
+    if (cfg->lta_s <= cfg->sta_s || cfg->lta_s > STREAM_MAX_LTA_S) {
+        printf("❌ %s: serve sta < lta <= %.0f s\n", filename, STREAM_MAX_LTA_S);
+        return 0;
+    }
+    cfg->active = 0;
+    if (active_name[0]) {
+        cfg->active = -1;
+        for (int k = 0; k < cfg->n_profiles; k++) {
+            if (strcmp(cfg->profiles[k].name, active_name) == 0) cfg->active = k;
+        }
+        if (cfg->active < 0) {
+            printf("❌ %s: profilo attivo '%s' non definito\n", filename, active_name);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Porta regressione e tabella soglie nei globali e ricava la soglia del
+// profilo attivo; con eng aggiorna anche il motore. Se il motore rifiuta
+// i nuovi valori i globali tornano com'erano: o tutto o niente
+static int apply_config(const DaemonConfig *cfg, StreamEngine *eng,
+                        AlarmThreshold *threshold) {
+    float reg[3] = {REG_INTERCEPT, REG_SLOPE, PRED_STD_DEV_LOG10};
+    AlarmThreshold saved[DAEMON_MAX_THRESHOLDS];
+    memcpy(saved, thresholds, cfg->n_table * sizeof(AlarmThreshold));
+
+    REG_INTERCEPT = cfg->reg_intercept;
+    REG_SLOPE = cfg->reg_slope;
+    PRED_STD_DEV_LOG10 = cfg->reg_sigma;
+    memcpy(thresholds, cfg->table, cfg->n_table * sizeof(AlarmThreshold));
+
+    const BuildingProfile *p = &cfg->profiles[cfg->active];
+    AlarmThreshold t = {p->type, p->state, 0.0f, 0.0f};
+    int ok = get_alarm_thresholds(t.type, t.state, &t.drift_limit, &t.prob_threshold);
+    if (ok && eng) {
+        ok = stream_reconfigure(eng, cfg->sta_s, cfg->lta_s, cfg->trigger_threshold,
+                                &t, cfg->ptm_s, p->height);
+    }
+    if (!ok) {
+        REG_INTERCEPT = reg[0];
+        REG_SLOPE = reg[1];
+        PRED_STD_DEV_LOG10 = reg[2];
+        memcpy(thresholds, saved, cfg->n_table * sizeof(AlarmThreshold));
+        return 0;
+    }
+    *threshold = t;
+    return 1;
+}
+
+static void print_profile(const DaemonConfig *cfg, const AlarmThreshold *t) {
+    const BuildingProfile *p = &cfg->profiles[cfg->active];
+    printf("  Profilo %s: %s, %s, %.1f m (drift %.4f, P > %.2f%%)\n", p->name,
+           building_keys[p->type], damage_keys[p->state], p->height,
+           t->drift_limit, t->prob_threshold * 100.0f);
+    printf("  STA=%.1fs, LTA=%.1fs, Soglia=%.1f, PTM=%.1fs, regressione "
+           "%.3f + %.3f log10(PGD), sigma %.3f\n", cfg->sta_s, cfg->lta_s,
+           cfg->trigger_threshold, cfg->ptm_s, cfg->reg_intercept,
+           cfg->reg_slope, cfg->reg_sigma);
+}
+
+static void on_daemon_event(const StreamEvent *ev, const StreamEngine *eng,
+                            void *ctx) {
+    DaemonContext *dc = (DaemonContext*)ctx;
+    dc->n_events++;
+    print_stream_event(ev, eng->trigger_idx, dc->dt);
+    if (ev->type & (STREAM_EVENT_ALARM | STREAM_EVENT_PTM_END)) {
+        dc->last = eng->results;
+    }
+    fflush(stdout);
+}
+
+// Ricarica tra due risvegli del server: i campioni già consegnati sono
+// stati elaborati con la configurazione precedente, i successivi (anche
+// se già in coda sul socket) con la nuova
+static void on_daemon_tick(StreamEngine *eng, void *ctx) {
+    DaemonContext *dc = (DaemonContext*)ctx;
+    if (!reload_requested) return;
+    reload_requested = 0;
+
+    printf("SIGHUP: rilettura di %s\n", dc->filename);
+    DaemonConfig next;
+    if (!daemon_config_load(dc->filename, &dc->compiled, &next)) {
+        printf("⚠ Ricarica annullata: configurazione invariata\n");
+        fflush(stdout);
+        return;
+    }
+    if (next.proto != dc->cfg.proto || next.port != dc->cfg.port ||
+        next.station != dc->cfg.station || next.fs != dc->cfg.fs ||
+        strcmp(next.live, dc->cfg.live) != 0) {
+        printf("⚠ proto, porta, stazione, fs e live richiedono un riavvio: "
+               "restano quelli in uso\n");
+        next.proto = dc->cfg.proto;
+        next.port = dc->cfg.port;
+        next.station = dc->cfg.station;
+        next.fs = dc->cfg.fs;
+        memcpy(next.live, dc->cfg.live, sizeof(next.live));
+    }
+
+    AlarmThreshold threshold;
+    if (!apply_config(&next, eng, &threshold)) {
+        printf("⚠ Ricarica annullata: valori non applicabili al motore\n");
+        fflush(stdout);
+        return;
+    }
+    dc->cfg = next;
+    dc->threshold = threshold;
+    dc->n_reloads++;
+    if (dc->live) live_publisher_set_profile(dc->live, &threshold,
+                                             next.profiles[next.active].height);
+    printf("✓ Configurazione applicata dal campione %ld\n", eng->n_pushed);
+    print_profile(&dc->cfg, &dc->threshold);
+    fflush(stdout);
+}
+
+int run_daemon(const char *config_file) {
+    DaemonContext dc;
+    memset(&dc, 0, sizeof(dc));
+    dc.filename = config_file;
+    compiled_defaults(&dc.compiled);
+    if (!daemon_config_load(config_file, &dc.compiled, &dc.cfg)) return 1;
+
+    FilterConfig filter;
+    init_filter_config(&filter, dc.cfg.fs);
+    if (filter.hp_a == 0.0f) {
+        printf("❌ ERRORE: Frequenza non supportata (%d Hz)\n", dc.cfg.fs);
+        return 1;
+    }
+    if (!apply_config(&dc.cfg, NULL, &dc.threshold)) {
+        printf("❌ ERRORE: Soglia non trovata per il profilo attivo\n");
+        cleanup_filter_config(&filter);
+        return 1;
+    }
+
+    const BuildingProfile *p = &dc.cfg.profiles[dc.cfg.active];
+    TriggerParams trigger;
+    init_trigger_params(&trigger, dc.cfg.sta_s, dc.cfg.lta_s);
+    trigger.threshold = dc.cfg.trigger_threshold;
+    StreamEngine eng;
+    IngestBuffer ib;
+    if (!stream_init(&eng, &filter, &trigger, &dc.threshold, dc.cfg.ptm_s,
+                     p->height)) {
+        printf("❌ ERRORE: Impossibile allocare il motore streaming\n");
+        cleanup_filter_config(&filter);
+        return 1;
+    }
+    if (!ingest_init(&ib, dc.cfg.station, dc.cfg.fs)) {
+        printf("❌ ERRORE: Impossibile allocare i buffer di acquisizione\n");
+        stream_free(&eng);
+        cleanup_filter_config(&filter);
+        return 1;
+    }
+
+    LivePublisher live_pub;
+    if (dc.cfg.live[0]) {
+        if (live_publisher_open(&live_pub, dc.cfg.live, dc.cfg.fs, &dc.threshold,
+                                p->height)) {
+            dc.live = &live_pub;
+            stream_set_live(&eng, dc.live);
+        } else {
+            printf("⚠ Stato live non disponibile (%s): si prosegue senza\n",
+                   dc.cfg.live);
+        }
+    }
+    dc.dt = filter.dt;
+    dc.last = eng.results;
+
+    printf("\n========== DEMONE DOSEWS ==========\n");
+    printf("Configurazione: %s (pid %d, SIGHUP per ricaricare)\n",
+           config_file, (int)getpid());
+    print_profile(&dc.cfg, &dc.threshold);
+    if (dc.live) printf("  Stato live: %s\n", dc.live->name);
+
+    // SIGHUP interrompe poll (niente SA_RESTART): ricarica al risveglio
+    struct sigaction sa, old_hup;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sighup;
+    sigaction(SIGHUP, &sa, &old_hup);
+    reload_requested = 0;
+
+    int ok = run_ingest_server(dc.cfg.proto, dc.cfg.port, &ib, &eng,
+                               on_daemon_event, on_daemon_tick, &dc);
+    sigaction(SIGHUP, &old_hup, NULL);
+
+    if (ok) {
+        if (eng.state == STREAM_MONITORING) dc.last = eng.results;
+        if (dc.n_events == 0) {
+            printf("✗ NESSUN TRIGGER\n");
+        } else {
+            print_final_report(&dc.last, &dc.threshold);
+        }
+        print_ingest_report(&ib.stats, eng.stats.samples, filter.dt);
+        printf("  Ricariche applicate: %d\n", dc.n_reloads);
+    }
+
+    if (dc.live) live_publisher_close(dc.live);
+    ingest_free(&ib);
+    stream_free(&eng);
+    cleanup_filter_config(&filter);
+    return ok ? 0 : 1;
+}
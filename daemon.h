@@ -0,0 +1,56 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "types.h"
+#include "ingest.h"
+
+// File di configurazione del demone: una voce "chiave = valore" per riga,
+// '#' commenta il resto della riga
+//   proto = udp|tcp          porta = N          stazione = N
+//   fs = Hz                  live = nome        (solo all'avvio)
+//   sta = s   lta = s   trigger = soglia STA/LTA   ptm = s
+//   reg_intercept = a   reg_slope = b   reg_sigma = s   (regressione drift)
+//   soglia = edificio danno drift_limite prob_%     (sostituisce la tabella)
+//   profilo = nome edificio danno altezza_m         (uno o più)
+//   attivo = nome                                   (default: il primo)
+// Con SIGHUP il file viene riletto e, se valido, applicato tutto insieme
+// tra due campioni; filtri, storia FIR e integratori restano quelli in uso
+#define DAEMON_MAX_PROFILES 16
+#define DAEMON_MAX_THRESHOLDS 32
+
+typedef struct {
+    char name[32];
+    BuildingType type;
+    DamageState state;
+    float height;
+} BuildingProfile;
+
+typedef struct {
+    // Solo all'avvio (socket, filtri, segmento live)
+    IngestProto proto;
+    int port;
+    int station;
+    int fs;
+    char live[64];            // Vuoto = nessuno stato live
+    
+    // Ricaricabili con SIGHUP
+    float sta_s, lta_s, ptm_s;
+    float trigger_threshold;
+    float reg_intercept, reg_slope, reg_sigma;
+    AlarmThreshold table[DAEMON_MAX_THRESHOLDS];
+    int n_table;
+    BuildingProfile profiles[DAEMON_MAX_PROFILES];
+    int n_profiles;
+    int active;
+} DaemonConfig;
+
+// Legge e valida il file partendo da base (valori compilati o in uso);
+// ritorna 0 con il primo errore stampato, cfg da ignorare
+int daemon_config_load(const char *filename, const DaemonConfig *base,
+                       DaemonConfig *cfg);
+
+// dosews --daemon file.conf: server di acquisizione con configurazione
+// ricaricabile a caldo (SIGHUP) e arresto pulito (SIGINT/SIGTERM)
+int run_daemon(const char *config_file);
+
+#endif
@@ -0,0 +1,139 @@
+#include "decimate.h"
+#include "fir_simd.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#define DECIM_RESPONSE_STEPS 200   // Punti per fs_out nella verifica della risposta
+
+// Risposta in ampiezza del filtro simmetrico alla frequenza f (cicli/campione)
+static double response_at(const double *h, int taps, int delay, double f) {
+    double sum = 0.0;
+    for (int k = 0; k < taps; k++) {
+        sum += h[k] * cos(2.0 * M_PI * f * (k - delay));
+    }
+    return sum;
+}
+
+int init_decimator(Decimator *dec, int fs_in, int fs_out) {
+    memset(dec, 0, sizeof(*dec));
+    if (fs_out < DECIM_MIN_FS || fs_out >= fs_in || fs_in % fs_out != 0) {
+        printf("⚠ Decimazione %d -> %d Hz non valida (rapporto intero >= 2, "
+               "minimo %d Hz)\n", fs_in, fs_out, DECIM_MIN_FS);
+        return 0;
+    }
+
+    int m = fs_in / fs_out;
+    int taps = DECIM_TAPS_PER_PHASE * m + 1;
+    int delay = (taps - 1) / 2;
+    double fc = 0.5 / m;            // Taglio a fs_out / 2 (cicli/campione)
+
+    // Sinc con finestra di Blackman, guadagno DC unitario
+    double *h = (double*)malloc(taps * sizeof(double));
+    if (!h) return 0;
+    double sum = 0.0;
+    for (int k = 0; k < taps; k++) {
+        double x = k - delay;
+        double sinc = (x == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * x) / (M_PI * x);
+        double w = 0.42 - 0.5 * cos(2.0 * M_PI * k / (taps - 1))
+                 + 0.08 * cos(4.0 * M_PI * k / (taps - 1));
+        h[k] = sinc * w;
+        sum += h[k];
+    }
+    for (int k = 0; k < taps; k++) h[k] /= sum;
+
+    // Scomposizione polifase: la fase p vede gli ingressi j*M + delay - p
+    dec->phase_len = DECIM_TAPS_PER_PHASE + 1;
+    dec->phases = (float*)calloc((size_t)m * dec->phase_len, sizeof(float));
+    if (!dec->phases) {
+        free(h);
+        return 0;
+    }
+    for (int k = 0; k < taps; k++) {
+        dec->phases[(k % m) * dec->phase_len + k / m] = (float)h[k];
+    }
+    fir_simd_init();
+
+    // Verifica: banda passante fino a DECIM_PASSBAND * fs_out e bande che
+    // dopo la decimazione ricadono nella banda passante
+    double step = 1.0 / (DECIM_RESPONSE_STEPS * m);
+    double pass_edge = DECIM_PASSBAND / m;
+    double max_err = 0.0, max_alias = 0.0;
+    for (double f = 0.0; f <= 0.5; f += step) {
+        double a = fabs(response_at(h, taps, delay, f));
+        if (f <= pass_edge) {
+            if (fabs(a - 1.0) > max_err) max_err = fabs(a - 1.0);
+        } else if (f >= 1.0 / m - pass_edge && a > max_alias) {
+            max_alias = a;
+        }
+    }
+    free(h);
+
+    dec->fs_in = fs_in;
+    dec->fs_out = fs_out;
+    dec->factor = m;
+    dec->taps = taps;
+    dec->delay = delay;
+    dec->passband_err = (float)max_err;
+    dec->alias_db = (max_alias > 0.0) ? (float)(-20.0 * log10(max_alias)) : 200.0f;
+
+    LOG_INFO("✓ Decimazione polifase %d -> %d Hz (M = %d)\n", fs_in, fs_out, m);
+    LOG_INFO("  Anti-alias: %d taps (%d per fase), fase zero\n",
+             taps, dec->phase_len);
+    LOG_INFO("  Banda 0-%.1f Hz: errore guadagno %.1e, alias attenuati di %.0f dB\n",
+             DECIM_PASSBAND * fs_out, dec->passband_err, dec->alias_db);
+    return 1;
+}
+
+int decimated_length(const Decimator *dec, int n) {
+    return (n + dec->factor - 1) / dec->factor;
+}
+
+int decimate_signal(const Decimator *dec, const float *in, int n,
+                    float scale, float *out) {
+    int m = dec->factor, q = dec->phase_len;
+    int n_out = decimated_length(dec, n);
+    int n_blocks = (n_out + DECIM_BLOCK - 1) / DECIM_BLOCK;
+
+    // Per blocco di uscite: ogni fase è una convoluzione corta sul proprio
+    // flusso di ingressi (stride M), calcolata con il kernel SIMD del FIR
+    int failed = 0;
+    #pragma omp parallel reduction(|:failed)
+    {
+        float *stream = (float*)malloc((q + DECIM_BLOCK) * sizeof(float));
+        float *part = (float*)malloc((q + DECIM_BLOCK) * sizeof(float));
+        failed = !stream || !part;
+
+        #pragma omp for schedule(static)
+        for (int b = 0; b < n_blocks; b++) {
+            if (failed) continue;
+            int j0 = b * DECIM_BLOCK;
+            int len = (n_out - j0 < DECIM_BLOCK) ? n_out - j0 : DECIM_BLOCK;
+            float *y = out + j0;
+            memset(y, 0, len * sizeof(float));
+
+            for (int p = 0; p < m; p++) {
+                // stream[t] = in[(j0 - q + t) * M + delay - p]
+                for (int t = 0; t < q + len; t++) {
+                    long idx = (long)(j0 - q + t) * m + dec->delay - p;
+                    stream[t] = (idx >= 0 && idx < n) ? in[idx] : 0.0f;
+                }
+                fir_simd_range(stream, part, q, q + len, dec->phases + p * q, q);
+                for (int t = 0; t < len; t++) y[t] += part[q + t];
+            }
+            for (int t = 0; t < len; t++) y[t] *= scale;
+        }
+
+        free(stream);
+        free(part);
+    }
+    return failed ? 0 : n_out;
+}
+
+void cleanup_decimator(Decimator *dec) {
+    free(dec->phases);
+    dec->phases = NULL;
+}
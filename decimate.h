@@ -0,0 +1,34 @@
+#ifndef DECIMATE_H
+#define DECIMATE_H
+
+// Decimazione polifase M:1 davanti alla pipeline (sensori MEMS a 500-1000 Hz):
+// passa-basso anti-alias a fase zero (sinc con finestra di Blackman) calcolato
+// solo sulle uscite conservate; a valle HP, FIR gaussiano, STA/LTA e drift
+// lavorano a fs_out con la FilterConfig di fs_out
+typedef struct {
+    int fs_in, fs_out;
+    int factor;           // M = fs_in / fs_out
+    int taps;             // Lunghezza anti-alias (DECIM_TAPS_PER_PHASE * M + 1)
+    int delay;            // Ritardo compensato (campioni a fs_in, multiplo di M)
+    int phase_len;        // Taps per fase
+    float *phases;        // M sottokernel: phases[p * phase_len + q] = h[q*M + p]
+    float passband_err;   // Errore di guadagno max fino a DECIM_PASSBAND * fs_out
+    float alias_db;       // Attenuazione min delle bande che ricadono in banda
+} Decimator;
+
+// Prepara il decimatore fs_in -> fs_out; 0 se il rapporto non è un intero
+// >= 2 o fs_out è sotto DECIM_MIN_FS
+int init_decimator(Decimator *dec, int fs_in, int fs_out);
+
+// Campioni in uscita per n in ingresso (uscita j allineata all'ingresso j*M)
+int decimated_length(const Decimator *dec, int n);
+
+// out[j] = scale * sum_k h[k] in[j*M + delay - k], ingresso nullo fuori da
+// [0, n); ritorna il numero di uscite, 0 se manca memoria
+int decimate_signal(const Decimator *dec, const float *in, int n,
+                    float scale, float *out);
+
+// Libera i sottokernel
+void cleanup_decimator(Decimator *dec);
+
+#endif
@@ -3,8 +3,11 @@
 #include "config.h"
 #include <math.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <float.h>
+#include <string.h>
 
-extern const AlarmThreshold thresholds[];
+extern AlarmThreshold thresholds[];
 extern const int NUM_THRESHOLDS;
 
 int get_alarm_thresholds(BuildingType type, DamageState state,
@@ -32,17 +35,144 @@ float calculate_exceedance_probability(float pgd_base, float drift_limit) {
     return 1.0f - prob_not_exceeding;
 }
 
-void perform_drift_analysis(SignalData *top, SignalData *base,
-                            TriggerParams *trigger, FilterConfig *filter,
-                            float ptm_len_s, float building_height,
-                            AlarmThreshold *threshold,
-                            AnalysisResults *results,
-                            const char *debug_file) {
+static uint32_t float_bits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static float bits_float(uint32_t u) {
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+float pgd_critical(float drift_limit, float prob_threshold) {
+    // Probabilità crescente con il PGD solo con pendenza positiva
+    if (REG_SLOPE <= 0.0f) return -1.0f;
+    if (!(prob_threshold < 1.0f)) return INFINITY;
+    if (prob_threshold < 0.0f) return 0.0f;
     
-    int start = trigger->trigger_idx;
+    // Inversione del modello log-normale: P = 1/2 erfc(z), z = (log10 dl -
+    // (a + b log10 pgd)) / (s sqrt 2); erf(z) = 1 - 2P risolta con Newton
+    double target = 1.0 - 2.0 * prob_threshold;
+    double z = 0.0;
+    for (int it = 0; it < 50; it++) {
+        double step = (erf(z) - target) / (2.0 / sqrt(M_PI) * exp(-z * z));
+        z -= step;
+        if (fabs(step) < 1e-12) break;
+    }
+    double log10_pgd = (log10(drift_limit) - z * PRED_STD_DEV_LOG10 * sqrt(2.0)
+                        - REG_INTERCEPT) / REG_SLOPE;
+    float guess = (float)pow(10.0, log10_pgd);
+    if (!(guess > 1e-9f)) guess = 1e-9f;
+    if (isinf(guess)) guess = FLT_MAX;
+    
+    // Allarme esattamente come con la formula in float: minimo pgd con
+    // P(pgd) > soglia, cercato sui bit (ordinati come i float positivi)
+    uint32_t lo = float_bits(1e-9f), hi = float_bits(INFINITY);
+    if (calculate_exceedance_probability(1e-9f, drift_limit) > prob_threshold) {
+        return 1e-9f;         // Sotto 1e-9 la probabilità è nulla
+    }
+    
+    // Intervallo (lo, hi] attorno alla stima, allargato a passi doppi
+    uint32_t g = float_bits(guess);
+    if (calculate_exceedance_probability(guess, drift_limit) > prob_threshold) {
+        hi = g;
+        for (uint32_t d = 1; d < g - lo; d <<= 1) {
+            if (calculate_exceedance_probability(bits_float(g - d), drift_limit)
+                <= prob_threshold) { lo = g - d; break; }
+            hi = g - d;
+        }
+    } else {
+        lo = g;
+        for (uint32_t d = 1; d < hi - g; d <<= 1) {
+            if (calculate_exceedance_probability(bits_float(g + d), drift_limit)
+                > prob_threshold) { hi = g + d; break; }
+            lo = g + d;
+        }
+    }
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (calculate_exceedance_probability(bits_float(mid), drift_limit)
+            > prob_threshold) hi = mid;
+        else lo = mid;
+    }
+    return bits_float(hi);
+}
+
+void fragility_init(FragilityMatrix *m, const AlarmThreshold *table, int n) {
+    if (n > FRAGILITY_MAX) n = FRAGILITY_MAX;
+    m->table = table;
+    m->n = n;
+    m->monotone = 1;
+    
+    for (int k = 0; k < n; k++) {
+        m->pgd_critical[k] = pgd_critical(table[k].drift_limit,
+                                          table[k].prob_threshold / 100.0f);
+        if (m->pgd_critical[k] < 0.0f) m->monotone = 0;
+        
+        // Inserimento ordinato (poche soglie)
+        int j = k;
+        while (j > 0 && m->pgd_critical[m->order[j-1]] > m->pgd_critical[k]) {
+            m->order[j] = m->order[j-1];
+            j--;
+        }
+        m->order[j] = k;
+    }
+    fragility_reset(m, 0);
+}
+
+void fragility_reset(FragilityMatrix *m, int start) {
+    m->next = 0;
+    m->pgd_base = 0.0f;
+    m->start = m->end = start;
+    for (int k = 0; k < m->n; k++) {
+        m->crossing_idx[k] = -1;
+        m->prob[k] = 0.0f;
+    }
+}
+
+void fragility_update(FragilityMatrix *m, float pgd_base, int i) {
+    m->pgd_base = pgd_base;
+    if (m->monotone) {
+        // Un confronto per campione: si avanza solo sulle soglie superate
+        while (m->next < m->n && pgd_base >= m->pgd_critical[m->order[m->next]]) {
+            m->crossing_idx[m->order[m->next++]] = i;
+        }
+        return;
+    }
+    for (int k = 0; k < m->n; k++) {
+        if (m->crossing_idx[k] < 0 &&
+            calculate_exceedance_probability(pgd_base, m->table[k].drift_limit) >
+            m->table[k].prob_threshold / 100.0f) {
+            m->crossing_idx[k] = i;
+            m->next++;
+        }
+    }
+}
+
+void fragility_finish(FragilityMatrix *m, int end) {
+    m->end = end;
+    for (int k = 0; k < m->n; k++) {
+        m->prob[k] = calculate_exceedance_probability(m->pgd_base,
+                                                      m->table[k].drift_limit);
+    }
+}
+
+void drift_monitor_init(DriftMonitor *mon, int start, int n,
+                        FilterConfig *filter, float ptm_len_s,
+                        float building_height, AlarmThreshold *threshold,
+                        AnalysisResults *results, const TraceOptions *trace,
+                        FragilityMatrix *matrix) {
     int ptm_len = (int)(ptm_len_s * filter->fs);
-    int end = start + ptm_len;
-    if (end > top->n_samples) end = top->n_samples;
+    
+    mon->filter = filter;
+    mon->threshold = threshold;
+    mon->results = results;
+    mon->start = start;
+    mon->end = start + ptm_len;
+    if (mon->end > n) mon->end = n;
     
     // Inizializza risultati
     results->pgd_base = 0.0f;
@@ -53,20 +183,181 @@ void perform_drift_analysis(SignalData *top, SignalData *base,
     results->alarm_idx = -1;
     
     // Altezza normalizzazione (2/3 per sensori solo top)
-    float norm_height = (2.0f / 3.0f) * building_height;
+    mon->norm_height = (2.0f / 3.0f) * building_height;
     
-    FILE *fdebug = fopen(debug_file, "w");
-    if (fdebug) {
-        fprintf(fdebug, "# t(s), PGD_base(m), Drift_abs(m), Drift_norm(mm/m), Prob(%%)\n");
-    }
+    // Log debug in memoria, formattato fuori dal loop
+    trace_open(&mon->ring, trace, mon->end - start);
     
-    int report_every = filter->fs;
-    int next_report = start + report_every;
+    // Soglia di allarme in PGD: il controllo per campione è un confronto
+    mon->pgd_critical = pgd_critical(threshold->drift_limit,
+                                     threshold->prob_threshold);
+    mon->prob = 0.0f;
+    mon->prob_stale = 0;
+    mon->matrix = matrix;
+    mon->tail = 0;
+    if (matrix) fragility_reset(matrix, start);
     
-    printf("ANALISI POST-TRIGGER...\n");
+    mon->report_every = filter->fs;
+    mon->next_report = start + mon->report_every;
+    
+    LOG_INFO("ANALISI POST-TRIGGER...\n");
     
     // ========== INTEGRAZIONE CORRETTA - COME NEL FORTRAN ==========
     // Inizializza al trigger
+    mon->top_vel_unf = mon->top_vel_filt = mon->top_disp = 0.0f;
+    mon->base_vel_unf = mon->base_vel_filt = mon->base_disp = 0.0f;
+}
+
+static void drift_monitor_update_prob(DriftMonitor *mon) {
+    AnalysisResults *results = mon->results;
+    mon->prob = calculate_exceedance_probability(results->pgd_base,
+                                                 mon->threshold->drift_limit);
+    mon->prob_stale = 0;
+    if (mon->prob > results->max_prob) {
+        results->max_prob = mon->prob;
+    }
+}
+
+int drift_monitor_step(DriftMonitor *mon, int i, float top_hp_prev,
+                       float top_hp, float base_hp_prev, float base_hp) {
+    FilterConfig *filter = mon->filter;
+    AnalysisResults *results = mon->results;
+    AlarmThreshold *threshold = mon->threshold;
+    int start = mon->start;
+    
+    // ===== INTEGRAZIONE TOP =====
+    // Integrazione trapezoidale acc -> velocità non filtrata
+    float top_vel_unf = mon->top_vel_unf + 
+                        (top_hp_prev + top_hp) * 0.5f * filter->dt;
+    
+    // High-pass sulla velocità (rimuove offset)
+    float top_vel_filt = top_vel_unf * filter->hp_b - 
+                         mon->top_vel_unf * filter->hp_b + 
+                         filter->hp_a * mon->top_vel_filt;
+    
+    // Integrazione trapezoidale velocità filtrata -> spostamento
+    mon->top_disp = mon->top_disp + 
+                    (mon->top_vel_filt + top_vel_filt) * 0.5f * filter->dt;
+    mon->top_vel_unf = top_vel_unf;
+    mon->top_vel_filt = top_vel_filt;
+    
+    // ===== INTEGRAZIONE BASE =====
+    // Integrazione trapezoidale acc -> velocità non filtrata
+    float base_vel_unf = mon->base_vel_unf + 
+                         (base_hp_prev + base_hp) * 0.5f * filter->dt;
+    
+    // High-pass sulla velocità
+    float base_vel_filt = base_vel_unf * filter->hp_b - 
+                          mon->base_vel_unf * filter->hp_b + 
+                          filter->hp_a * mon->base_vel_filt;
+    
+    // Integrazione trapezoidale velocità filtrata -> spostamento
+    mon->base_disp = mon->base_disp + 
+                     (mon->base_vel_filt + base_vel_filt) * 0.5f * filter->dt;
+    mon->base_vel_unf = base_vel_unf;
+    mon->base_vel_filt = base_vel_filt;
+    
+    // Dopo l'allarme conta solo il PGD base, per le soglie rimaste
+    if (mon->tail) {
+        float abs_disp_base = fabsf(mon->base_disp);
+        if (abs_disp_base > mon->matrix->pgd_base) {
+            fragility_update(mon->matrix, abs_disp_base, i);
+        }
+        mon->matrix->end = i + 1;
+        return fragility_complete(mon->matrix);
+    }
+    
+    // ===== CALCOLO DRIFT E ANALISI =====
+    float drift_abs = mon->top_disp - mon->base_disp;
+    float drift_norm = drift_abs / mon->norm_height;
+    
+    // Aggiorna massimi
+    float abs_disp_base = fabsf(mon->base_disp);
+    if (abs_disp_base > results->pgd_base) {
+        results->pgd_base = abs_disp_base;
+        mon->prob_stale = 1;
+        if (mon->matrix) fragility_update(mon->matrix, abs_disp_base, i);
+    }
+    
+    if (fabsf(drift_abs) > results->max_drift_abs) {
+        results->max_drift_abs = fabsf(drift_abs);
+    }
+    
+    if (fabsf(drift_norm) > results->max_drift_norm) {
+        results->max_drift_norm = fabsf(drift_norm);
+    }
+    
+    // Allarme: P(pgd_base) > soglia equivale a pgd_base >= pgd_critical
+    int alarm = (mon->pgd_critical >= 0.0f)
+                ? results->pgd_base >= mon->pgd_critical
+                : -1;
+    
+    // Probabilità solo se il PGD è cambiato e serve (log, report, allarme)
+    long step = i - start - 1;
+    int report = i >= mon->next_report;
+    if (mon->prob_stale && (alarm != 0 || report || trace_wants(&mon->ring, step))) {
+        drift_monitor_update_prob(mon);
+    }
+    if (alarm < 0) alarm = mon->prob > threshold->prob_threshold;
+    float prob = mon->prob;
+    
+    // Log debug
+    TraceRecord rec = {i * filter->dt, results->pgd_base,
+                       results->max_drift_abs,
+                       results->max_drift_norm * 1000, prob * 100.0f};
+    trace_push(&mon->ring, step, &rec);
+    
+    // Report periodico
+    if (report) {
+        LOG_INFO("  T+%.1fs: PGD=%.5fm, Drift=%.2f mm/m, P=%.2f%%\n",
+                 (i - start) * filter->dt, results->pgd_base,
+                 results->max_drift_norm * 1000, prob * 100.0f);
+        mon->next_report += mon->report_every;
+    }
+    
+    // Check allarme
+    if (alarm) {
+        results->alarm_triggered = 1;
+        results->alarm_idx = i;
+        
+        LOG_INFO("\n*** ALLARME ROSSO! ***\n");
+        LOG_INFO("Tempo: %.3f s dopo trigger\n", (i - start) * filter->dt);
+        LOG_INFO("PGD base: %.5f m\n", results->pgd_base);
+        LOG_INFO("Drift normalizzato: %.2f mm/m\n", 
+                 results->max_drift_norm * 1000);
+        LOG_INFO("Probabilità: %.2f%% > %.2f%%\n",
+                 prob * 100.0f, threshold->prob_threshold * 100.0f);
+        if (mon->matrix && !fragility_complete(mon->matrix)) {
+            mon->tail = 1;
+            mon->matrix->end = i + 1;
+            return 0;
+        }
+        return 1;
+    }
+    if (mon->matrix) mon->matrix->end = i + 1;
+    return 0;
+}
+
+void drift_monitor_close(DriftMonitor *mon) {
+    // max_prob = P(pgd_base finale): la probabilità cresce con il PGD
+    if (mon->prob_stale) drift_monitor_update_prob(mon);
+    if (mon->matrix) fragility_finish(mon->matrix, mon->matrix->end);
+    trace_close(&mon->ring);
+}
+
+void perform_drift_analysis(SignalData *top, SignalData *base,
+                            TriggerParams *trigger, FilterConfig *filter,
+                            float ptm_len_s, float building_height,
+                            AlarmThreshold *threshold,
+                            AnalysisResults *results,
+                            const TraceOptions *trace,
+                            FragilityMatrix *matrix) {
+    
+    int start = trigger->trigger_idx;
+    DriftMonitor mon;
+    drift_monitor_init(&mon, start, top->n_samples, filter, ptm_len_s,
+                       building_height, threshold, results, trace, matrix);
+    
     top->vel_unf[start] = 0.0f;
     top->vel_filt[start] = 0.0f;
     top->disp[start] = 0.0f;
@@ -75,93 +366,24 @@ void perform_drift_analysis(SignalData *top, SignalData *base,
     base->disp[start] = 0.0f;
     
     // Loop di integrazione sequenziale - NON chiamare funzioni che resettano!
-    for (int i = start + 1; i < end && !results->alarm_triggered; i++) {
-        
-        // ===== INTEGRAZIONE TOP =====
-        // Integrazione trapezoidale acc -> velocità non filtrata
-        top->vel_unf[i] = top->vel_unf[i-1] + 
-                          (top->acc_hp[i-1] + top->acc_hp[i]) * 0.5f * filter->dt;
-        
-        // High-pass sulla velocità (rimuove offset)
-        top->vel_filt[i] = top->vel_unf[i] * filter->hp_b - 
-                           top->vel_unf[i-1] * filter->hp_b + 
-                           filter->hp_a * top->vel_filt[i-1];
-        
-        // Integrazione trapezoidale velocità filtrata -> spostamento
-        top->disp[i] = top->disp[i-1] + 
-                       (top->vel_filt[i-1] + top->vel_filt[i]) * 0.5f * filter->dt;
-        
-        // ===== INTEGRAZIONE BASE =====
-        // Integrazione trapezoidale acc -> velocità non filtrata
-        base->vel_unf[i] = base->vel_unf[i-1] + 
-                           (base->acc_hp[i-1] + base->acc_hp[i]) * 0.5f * filter->dt;
-        
-        // High-pass sulla velocità
-        base->vel_filt[i] = base->vel_unf[i] * filter->hp_b - 
-                            base->vel_unf[i-1] * filter->hp_b + 
-                            filter->hp_a * base->vel_filt[i-1];
-        
-        // Integrazione trapezoidale velocità filtrata -> spostamento
-        base->disp[i] = base->disp[i-1] + 
-                        (base->vel_filt[i-1] + base->vel_filt[i]) * 0.5f * filter->dt;
-        
-        // ===== CALCOLO DRIFT E ANALISI =====
-        float drift_abs = top->disp[i] - base->disp[i];
-        float drift_norm = drift_abs / norm_height;
-        
-        // Aggiorna massimi
-        float abs_disp_base = fabsf(base->disp[i]);
-        if (abs_disp_base > results->pgd_base) {
-            results->pgd_base = abs_disp_base;
-        }
-        
-        if (fabsf(drift_abs) > results->max_drift_abs) {
-            results->max_drift_abs = fabsf(drift_abs);
+    for (int i = start + 1; i < mon.end; i++) {
+        int tail = mon.tail;
+        int done = drift_monitor_step(&mon, i, top->acc_hp[i-1], top->acc_hp[i],
+                                      base->acc_hp[i-1], base->acc_hp[i]);
+        if (tail) {
+            if (done) break;
+            continue;         // Oltre l'allarme: array come senza matrice
         }
         
-        if (fabsf(drift_norm) > results->max_drift_norm) {
-            results->max_drift_norm = fabsf(drift_norm);
-        }
-        
-        // Calcola probabilità
-        float prob = calculate_exceedance_probability(results->pgd_base, 
-                                                      threshold->drift_limit);
-        
-        if (prob > results->max_prob) {
-            results->max_prob = prob;
-        }
+        top->vel_unf[i] = mon.top_vel_unf;
+        top->vel_filt[i] = mon.top_vel_filt;
+        top->disp[i] = mon.top_disp;
+        base->vel_unf[i] = mon.base_vel_unf;
+        base->vel_filt[i] = mon.base_vel_filt;
+        base->disp[i] = mon.base_disp;
         
-        // Log debug
-        if (fdebug) {
-            fprintf(fdebug, "%.3f, %.6e, %.6e, %.2f, %.2f\n",
-                    i * filter->dt, results->pgd_base, 
-                    results->max_drift_abs, results->max_drift_norm * 1000,
-                    prob * 100.0f);
-        }
-        
-        // Report periodico
-        if (i >= next_report) {
-            printf("  T+%.1fs: PGD=%.5fm, Drift=%.2f mm/m, P=%.2f%%\n",
-                   (i - start) * filter->dt, results->pgd_base,
-                   results->max_drift_norm * 1000, prob * 100.0f);
-            next_report += report_every;
-        }
-        
-        // Check allarme
-        if (prob > threshold->prob_threshold) {
-            results->alarm_triggered = 1;
-            results->alarm_idx = i;
-            
-            printf("\n*** ALLARME ROSSO! ***\n");
-            printf("Tempo: %.3f s dopo trigger\n", (i - start) * filter->dt);
-            printf("PGD base: %.5f m\n", results->pgd_base);
-            printf("Drift normalizzato: %.2f mm/m\n", 
-                   results->max_drift_norm * 1000);
-            printf("Probabilità: %.2f%% > %.2f%%\n",
-                   prob * 100.0f, threshold->prob_threshold * 100.0f);
-            break;
-        }
+        if (done) break;
     }
     
-    if (fdebug) fclose(fdebug);
-}
\ No newline at end of file
+    drift_monitor_close(&mon);
+}
@@ -2,6 +2,7 @@
 #define DRIFT_ANALYSIS_H
 
 #include "types.h"
+#include "trace.h"
 
 // Trova soglie per tipo edificio e danno
 int get_alarm_thresholds(BuildingType type, DamageState state,
@@ -10,12 +11,89 @@ int get_alarm_thresholds(BuildingType type, DamageState state,
 // Calcola probabilità di superamento
 float calculate_exceedance_probability(float pgd_base, float drift_limit);
 
-// Analisi post-trigger completa
+// Minimo PGD con probabilità > prob_threshold (stessa formula in float):
+// l'allarme scatta quando pgd_base >= pgd_critical. INFINITY se mai
+// raggiunta, -1 se il modello non è crescente nel PGD
+float pgd_critical(float drift_limit, float prob_threshold);
+
+#define FRAGILITY_MAX 32
+
+// Matrice di fragilità: tutte le soglie della tabella valutate sullo stesso
+// PGD base. Con la probabilità crescente nel PGD ogni soglia si riduce a
+// pgd_critical; le soglie ordinate si superano in sequenza
+typedef struct {
+    const AlarmThreshold *table;
+    int n;
+    int monotone;                       // pgd_critical valido per tutte
+    float pgd_critical[FRAGILITY_MAX];
+    int order[FRAGILITY_MAX];           // Indici per pgd_critical crescente
+    int next;                           // Prossima soglia (in order)
+    int crossing_idx[FRAGILITY_MAX];    // Primo campione oltre soglia, -1
+    float prob[FRAGILITY_MAX];          // Probabilità al PGD finale
+    float pgd_base;                     // PGD base sull'intera finestra
+    int start, end;                     // Trigger e fine finestra analizzata
+} FragilityMatrix;
+
+// Prepara la matrice per le prime n soglie della tabella (n <= FRAGILITY_MAX)
+void fragility_init(FragilityMatrix *m, const AlarmThreshold *table, int n);
+
+// Azzera gli attraversamenti al trigger start
+void fragility_reset(FragilityMatrix *m, int start);
+
+// Nuovo PGD base al campione i
+void fragility_update(FragilityMatrix *m, float pgd_base, int i);
+
+// Vero se tutte le soglie sono già state superate
+static inline int fragility_complete(const FragilityMatrix *m) {
+    return m->next >= m->n;
+}
+
+// Probabilità finali di tutte le soglie (fine finestra i esclusa)
+void fragility_finish(FragilityMatrix *m, int end);
+
+// Stato dell'analisi post-trigger, avanzato un campione alla volta
+typedef struct {
+    FilterConfig *filter;
+    AlarmThreshold *threshold;
+    AnalysisResults *results;
+    int start, end;           // Trigger e fine finestra (esclusa)
+    float norm_height;
+    int report_every, next_report;
+    float pgd_critical;       // Soglia di allarme sul PGD base
+    float prob;               // Probabilità all'ultimo PGD valutato
+    int prob_stale;           // PGD cresciuto dopo l'ultima valutazione
+    FragilityMatrix *matrix;  // NULL = solo la soglia selezionata
+    int tail;                 // Dopo l'allarme: solo BASE, per la matrice
+    float top_vel_unf, top_vel_filt, top_disp;
+    float base_vel_unf, base_vel_filt, base_disp;
+    TraceRing ring;
+} DriftMonitor;
+
+// Azzera risultati e integratori al campione di trigger start. Con matrix
+// l'analisi prosegue dopo l'allarme finché tutte le soglie sono superate
+void drift_monitor_init(DriftMonitor *mon, int start, int n,
+                        FilterConfig *filter, float ptm_len_s,
+                        float building_height, AlarmThreshold *threshold,
+                        AnalysisResults *results, const TraceOptions *trace,
+                        FragilityMatrix *matrix);
+
+// Integra il campione i (start < i < end) da acc_hp a i-1 e i; 1 se l'analisi
+// è conclusa (allarme, e con la matrice tutte le soglie superate). Con
+// mon->tail già attivo prima del passo gli integratori non vanno salvati
+int drift_monitor_step(DriftMonitor *mon, int i, float top_hp_prev,
+                       float top_hp, float base_hp_prev, float base_hp);
+
+// Scrive il log debug e libera il ring
+void drift_monitor_close(DriftMonitor *mon);
+
+// Analisi post-trigger completa (log debug secondo trace, NULL = nessuno;
+// matrice di fragilità opzionale)
 void perform_drift_analysis(SignalData *top, SignalData *base,
                             TriggerParams *trigger, FilterConfig *filter,
                             float ptm_len_s, float building_height,
                             AlarmThreshold *threshold,
                             AnalysisResults *results,
-                            const char *debug_file);
+                            const TraceOptions *trace,
+                            FragilityMatrix *matrix);
 
 #endif
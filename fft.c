@@ -0,0 +1,154 @@
+#include "fft.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+int fft_plan_init(FftPlan *plan, int n) {
+    int h = n / 2;
+    plan->n = n;
+    plan->tw = plan->tw_real = NULL;
+    plan->bitrev = NULL;
+    if (n < 4 || (n & (n - 1))) return 0;
+
+    plan->tw = (float*)malloc(h * sizeof(float));          // h/2 complessi
+    plan->tw_real = (float*)malloc(h * sizeof(float));     // h/2 complessi
+    plan->bitrev = (int*)malloc(h * sizeof(int));
+    if (!plan->tw || !plan->tw_real || !plan->bitrev) {
+        fft_plan_free(plan);
+        return 0;
+    }
+
+    // Twiddle calcolati in doppia precisione
+    const double PI = 3.14159265358979323846;
+    for (int j = 0; j < h / 2; j++) {
+        plan->tw[2*j]   = (float)cos(-2.0 * PI * j / h);
+        plan->tw[2*j+1] = (float)sin(-2.0 * PI * j / h);
+        plan->tw_real[2*j]   = (float)cos(-2.0 * PI * j / n);
+        plan->tw_real[2*j+1] = (float)sin(-2.0 * PI * j / n);
+    }
+
+    int bits = 0;
+    while ((1 << bits) < h) bits++;
+    for (int i = 0; i < h; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        plan->bitrev[i] = r;
+    }
+    return 1;
+}
+
+void fft_plan_free(FftPlan *plan) {
+    free(plan->tw);
+    free(plan->tw_real);
+    free(plan->bitrev);
+    plan->tw = plan->tw_real = NULL;
+    plan->bitrev = NULL;
+}
+
+// FFT complessa radix-2 in-place su h punti; inverse = coniuga i twiddle
+static void fft_complex(const FftPlan *plan, float *z, int inverse) {
+    int h = plan->n / 2;
+
+    for (int i = 0; i < h; i++) {
+        int r = plan->bitrev[i];
+        if (r > i) {
+            float tr = z[2*i], ti = z[2*i+1];
+            z[2*i] = z[2*r];
+            z[2*i+1] = z[2*r+1];
+            z[2*r] = tr;
+            z[2*r+1] = ti;
+        }
+    }
+
+    float sign = inverse ? -1.0f : 1.0f;
+    for (int len = 2; len <= h; len <<= 1) {
+        int half = len / 2;
+        int step = h / len;
+        for (int s = 0; s < h; s += len) {
+            for (int j = 0; j < half; j++) {
+                float wr = plan->tw[2*j*step];
+                float wi = sign * plan->tw[2*j*step+1];
+                float *a = z + 2*(s + j);
+                float *b = z + 2*(s + j + half);
+                float br = b[0] * wr - b[1] * wi;
+                float bi = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - br;
+                b[1] = a[1] - bi;
+                a[0] += br;
+                a[1] += bi;
+            }
+        }
+    }
+}
+
+void fft_real_forward(const FftPlan *plan, const float *in, float *spec) {
+    int h = plan->n / 2;
+
+    // Campioni pari/dispari impacchettati come z[m] = x[2m] + i x[2m+1]
+    memcpy(spec, in, plan->n * sizeof(float));
+    fft_complex(plan, spec, 0);
+
+    float z0r = spec[0], z0i = spec[1];
+    spec[0] = z0r + z0i;
+    spec[1] = 0.0f;
+    spec[2*h] = z0r - z0i;
+    spec[2*h+1] = 0.0f;
+
+    // Ricombina le coppie (k, h-k): X = Fe + W^k Fo
+    for (int k = 1; k <= h / 2; k++) {
+        int m = h - k;
+        float ar = spec[2*k], ai = spec[2*k+1];
+        float br = spec[2*m], bi = spec[2*m+1];
+
+        float fer = 0.5f * (ar + br), fei = 0.5f * (ai - bi);
+        float for_ = 0.5f * (ai + bi), foi = -0.5f * (ar - br);
+        // W^(h/2) = -i non è in tabella
+        float wr = (k < h / 2) ? plan->tw_real[2*k] : 0.0f;
+        float wi = (k < h / 2) ? plan->tw_real[2*k+1] : -1.0f;
+
+        float tr = wr * for_ - wi * foi;
+        float ti = wr * foi + wi * for_;
+        spec[2*k] = fer + tr;
+        spec[2*k+1] = fei + ti;
+        // X[h-k] = conj(Fe - W^k Fo)
+        spec[2*m] = fer - tr;
+        spec[2*m+1] = -(fei - ti);
+    }
+}
+
+void fft_real_inverse(const FftPlan *plan, float *spec, float *out) {
+    int h = plan->n / 2;
+
+    float x0 = spec[0], xh = spec[2*h];
+    spec[0] = 0.5f * (x0 + xh);
+    spec[1] = 0.5f * (x0 - xh);
+
+    // Z = Fe + i Fo con Fe = (X[k] + conj X[h-k])/2, Fo = (X[k] - conj X[h-k]) W^-k / 2
+    for (int k = 1; k <= h / 2; k++) {
+        int m = h - k;
+        float ar = spec[2*k], ai = spec[2*k+1];
+        float br = spec[2*m], bi = spec[2*m+1];
+
+        float fer = 0.5f * (ar + br), fei = 0.5f * (ai - bi);
+        float dr = 0.5f * (ar - br), di = 0.5f * (ai + bi);
+        float wr = (k < h / 2) ? plan->tw_real[2*k] : 0.0f;
+        float wi = (k < h / 2) ? -plan->tw_real[2*k+1] : 1.0f;
+
+        float for_ = dr * wr - di * wi;
+        float foi = dr * wi + di * wr;
+        // Z[k] = Fe + i Fo, Z[h-k] = conj(Fe) + i conj(Fo)
+        spec[2*k] = fer - foi;
+        spec[2*k+1] = fei + for_;
+        spec[2*m] = fer + foi;
+        spec[2*m+1] = -fei + for_;
+    }
+
+    fft_complex(plan, spec, 1);
+
+    float scale = 1.0f / h;
+    for (int i = 0; i < plan->n; i++) {
+        out[i] = spec[i] * scale;
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef FFT_H
+#define FFT_H
+
+// Piano FFT reale radix-2 (lunghezza potenza di 2)
+typedef struct {
+    int n;                // Lunghezza trasformata reale
+    float *tw;            // Twiddle FFT complessa di lunghezza n/2
+    float *tw_real;       // Twiddle W^k per ricombinazione reale
+    int *bitrev;          // Permutazione bit-reversal (n/2)
+} FftPlan;
+
+// Crea piano per lunghezza n (potenza di 2, n >= 4)
+int fft_plan_init(FftPlan *plan, int n);
+
+// Libera piano
+void fft_plan_free(FftPlan *plan);
+
+// FFT reale diretta: in[n] -> spec[n+2] (n/2+1 bin complessi interleaved)
+void fft_real_forward(const FftPlan *plan, const float *in, float *spec);
+
+// FFT reale inversa (normalizzata): spec[n+2] -> out[n], spec viene sovrascritto
+void fft_real_inverse(const FftPlan *plan, float *spec, float *out);
+
+#endif
@@ -0,0 +1,188 @@
+#include "filter_cache.h"
+#include "signal_processing.h"
+#include "fir_simd.h"
+#include "scan.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define FNV_OFFSET 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+#define FNV_LANES 4
+
+// FNV-1a a parole da 64 bit su 4 corsie indipendenti (la moltiplicazione
+// non è più in catena su ogni byte); il ripiegamento h >> 32 porta i bit
+// alti delle parole verso il basso. Le corsie si combinano alla fine
+static uint64_t fnv1a(const void *data, size_t len, uint64_t seed) {
+    const uint8_t *p = (const uint8_t*)data;
+    uint64_t lane[FNV_LANES];
+    for (int l = 0; l < FNV_LANES; l++) lane[l] = seed ^ (uint64_t)l;
+
+    size_t i = 0;
+    for (; i + 8 * FNV_LANES <= len; i += 8 * FNV_LANES) {
+        for (int l = 0; l < FNV_LANES; l++) {
+            uint64_t w;
+            memcpy(&w, p + i + 8 * l, sizeof(w));
+            lane[l] = (lane[l] ^ w) * FNV_PRIME;
+            lane[l] ^= lane[l] >> 32;
+        }
+    }
+
+    uint64_t h = seed;
+    for (; i < len; i++) h = (h ^ p[i]) * FNV_PRIME;
+    for (int l = 0; l < FNV_LANES; l++) h = (h ^ lane[l]) * FNV_PRIME;
+    return (h ^ (uint64_t)len) * FNV_PRIME;
+}
+
+uint64_t filter_cache_hash(const void *data, size_t len) {
+    uint64_t h = fnv1a(data, len, FNV_OFFSET);
+    return h ? h : 1;
+}
+
+uint64_t filter_cache_key(uint64_t hash_top, uint64_t hash_base,
+                          int base_channel, int fs_in, float unit_conv,
+                          const FilterConfig *filter) {
+    // Campi azzerati prima: il padding non entra nella chiave
+    struct {
+        uint64_t hash_top, hash_base;
+        int32_t version, base_channel, fs_in, fs;
+        int32_t filter_len, kernel_offset, kernel_eff_len, fir_mode;
+        int32_t isa, decim_taps;
+        float unit_conv, hp_a, hp_b, prune_tol;
+    } p;
+    memset(&p, 0, sizeof(p));
+    p.hash_top = hash_top;
+    p.hash_base = hash_base;
+    p.version = FILTER_CACHE_VERSION;
+    p.base_channel = base_channel;
+    p.fs_in = fs_in;
+    p.fs = filter->fs;
+    p.filter_len = filter->filter_len;
+    p.kernel_offset = filter->kernel_offset;
+    p.kernel_eff_len = filter->kernel_eff_len;
+    p.fir_mode = filter->fir_mode;
+    p.isa = fir_simd_init();      // Somme SIMD: risultati diversi bit a bit
+    p.decim_taps = DECIM_TAPS_PER_PHASE;
+    p.unit_conv = unit_conv;
+    p.hp_a = filter->hp_a;
+    p.hp_b = filter->hp_b;
+    p.prune_tol = filter->prune_tol;
+
+    uint64_t h = fnv1a(&p, sizeof(p), FNV_OFFSET);
+    h = fnv1a(filter->kernel, filter->filter_len * sizeof(float), h);
+    return h ? h : 1;
+}
+
+// Etichetta nel file: chiave più blocchi della scan HP per gli n campioni
+// salvati (la scan parallela arrotonda in base ai thread). n si conosce
+// solo dal file, per cui entra nell'etichetta e non nel nome
+static uint64_t cache_tag(uint64_t key, int n) {
+    int32_t blocks = scan_parallel_enabled(n) ? scan_blocks(n) : 0;
+    uint64_t h = fnv1a(&blocks, sizeof(blocks), key);
+    return h ? h : 1;
+}
+
+static void cache_path(FilterCache *cache, uint64_t key) {
+    const char *dir = getenv(FILTER_CACHE_ENV);
+    if (!dir || !*dir) dir = FILTER_CACHE_DEFAULT_DIR;
+    snprintf(cache->path, sizeof(cache->path), "%s/%016llx.dwsf",
+             dir, (unsigned long long)key);
+    cache->key = key;
+}
+
+int filter_cache_load(FilterCache *cache, uint64_t key, const FilterConfig *filter,
+                      SignalData *top, SignalData *base) {
+    memset(&cache->wf, 0, sizeof(cache->wf));
+    cache_path(cache, key);
+
+    struct stat st;
+    if (stat(cache->path, &st) != 0) return -1;
+    if (!waveform_open(&cache->wf, cache->path)) return -1;
+
+    const WaveformHeader *h = &cache->wf.hdr;
+    if (h->n_channels != FILTER_CACHE_CHANNELS || (int)h->fs != filter->fs ||
+        h->unit != WAVEFORM_UNIT_MS2 || h->n_samples == 0 ||
+        h->n_samples > MAX_SAMPLES ||
+        waveform_tag(&cache->wf) != cache_tag(key, (int)h->n_samples)) {
+        printf("⚠ Cache %s non valida: si ricalcola\n", cache->path);
+        waveform_close(&cache->wf);
+        return -1;
+    }
+
+    // Spazio per entrambi i canali prima di toccarli: se manca, i canali
+    // già letti restano validi per il calcolo completo
+    int n = (int)h->n_samples;
+    SignalData *data[2] = {top, base};
+    for (int c = 0; c < 2; c++) {
+        if (!reserve_signal_data(data[c], n)) {
+            waveform_close(&cache->wf);
+            return -1;
+        }
+    }
+    for (int c = 0; c < 2; c++) {
+        // acc resta sul file mappato, HP e FIR si copiano nell'arena
+        detach_external_acc(data[c]);
+        attach_external_acc(data[c], waveform_channel(&cache->wf, 3 * c), 1.0f);
+        memcpy(data[c]->acc_hp, waveform_channel(&cache->wf, 3 * c + 1),
+               n * sizeof(float));
+        memcpy(data[c]->acc_fir, waveform_channel(&cache->wf, 3 * c + 2),
+               n * sizeof(float));
+    }
+    return n;
+}
+
+int filter_cache_store(FilterCache *cache, uint64_t key, const FilterConfig *filter,
+                       const SignalData *top, const SignalData *base, int n) {
+    cache_path(cache, key);
+    char *slash = strrchr(cache->path, '/');
+    *slash = '\0';
+    if (mkdir(cache->path, 0755) != 0 && errno != EEXIST) {
+        *slash = '/';
+        return 0;
+    }
+    *slash = '/';
+
+    // acc salvata in m/s² (i .dwsf mappati in g hanno acc_scale != 1)
+    const SignalData *data[2] = {top, base};
+    float *scaled[2] = {NULL, NULL};
+    const float *channels[FILTER_CACHE_CHANNELS];
+    int ok = 1;
+    for (int c = 0; c < 2; c++) {
+        const float *acc = data[c]->acc;
+        if (data[c]->acc_scale != 1.0f) {
+            scaled[c] = (float*)malloc(n * sizeof(float));
+            if (!scaled[c]) {
+                ok = 0;
+                break;
+            }
+            for (int i = 0; i < n; i++) scaled[c][i] = acc[i] * data[c]->acc_scale;
+            acc = scaled[c];
+        }
+        channels[3 * c] = acc;
+        channels[3 * c + 1] = data[c]->acc_hp;
+        channels[3 * c + 2] = data[c]->acc_fir;
+    }
+
+    // File temporaneo e rename: un'altra esecuzione non vede mai un file a metà
+    char tmp[sizeof(cache->path) + 16];
+    snprintf(tmp, sizeof(tmp), "%s.%d", cache->path, (int)getpid());
+    if (ok) {
+        ok = waveform_write_tagged(tmp, filter->fs, WAVEFORM_UNIT_MS2, 0.0,
+                                   channels, FILTER_CACHE_CHANNELS, n,
+                                   cache_tag(key, n));
+    }
+    if (ok && rename(tmp, cache->path) != 0) ok = 0;
+    if (!ok) unlink(tmp);
+
+    free(scaled[0]);
+    free(scaled[1]);
+    return ok;
+}
+
+void filter_cache_close(FilterCache *cache) {
+    waveform_close(&cache->wf);
+}
@@ -0,0 +1,49 @@
+#ifndef FILTER_CACHE_H
+#define FILTER_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+#include "waveform.h"
+
+// Cache su disco dei segnali filtrati (opzionale, --cache): acc (m/s², già
+// decimata), acc_hp e acc_fir di TOP e BASE in un .dwsf a 6 canali, con la
+// chiave nell'etichetta dell'header. Dipende solo da contenuto dei file,
+// unità, fs, decimazione e filtri: cambiando edificio, danno o altezza si
+// saltano parsing, decimazione e filtraggio
+#define FILTER_CACHE_VERSION 1
+#define FILTER_CACHE_ENV "DOSEWS_CACHE"         // Directory alternativa
+#define FILTER_CACHE_DEFAULT_DIR ".dosews_cache"
+#define FILTER_CACHE_CHANNELS 6
+
+typedef struct {
+    uint64_t key;
+    char path[512];
+    WaveformFile wf;          // File mappato (acc dei canali punta qui)
+} FilterCache;
+
+// Impronta FNV-1a del contenuto di un file già in memoria (mai 0)
+uint64_t filter_cache_hash(const void *data, size_t len);
+
+// Chiave: impronte dei file più i parametri che determinano acc, acc_hp e
+// acc_fir (fs di ingresso e di elaborazione, unità, canale BASE, kernel).
+// I blocchi della scan HP dipendono dai campioni: si verificano
+// sull'etichetta del file
+uint64_t filter_cache_key(uint64_t hash_top, uint64_t hash_base,
+                          int base_channel, int fs_in, float unit_conv,
+                          const FilterConfig *filter);
+
+// Cerca la chiave; se valida mappa il file, collega acc e copia acc_hp e
+// acc_fir nei SignalData. Ritorna i campioni, -1 se assente o non valida
+// (SignalData invariati)
+int filter_cache_load(FilterCache *cache, uint64_t key, const FilterConfig *filter,
+                      SignalData *top, SignalData *base);
+
+// Salva i segnali filtrati sotto la chiave (scrittura atomica con rename)
+int filter_cache_store(FilterCache *cache, uint64_t key, const FilterConfig *filter,
+                       const SignalData *top, const SignalData *base, int n);
+
+// Rilascia la mappatura
+void filter_cache_close(FilterCache *cache);
+
+#endif
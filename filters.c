@@ -1,5 +1,12 @@
 #include "filters.h"
+#include "fft.h"
+#include "recursive_gaussian.h"
+#include "fir_simd.h"
+#include "scan.h"
+#include "std_rates.h"
+#include "config.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <stdio.h>
 #include <omp.h>
@@ -29,41 +36,87 @@ void init_filter_config(FilterConfig *config, int fs) {
         return;
     }
     
-    // Usa coefficienti predefiniti per le frequenze standard (più accurati)
-    // altrimenti calcola automaticamente
-    switch (fs) {
-        case 128: 
-            config->hp_b = 0.9981626f; 
-            config->hp_a = 0.99632521f;
-            printf("✓ Usando coefficienti predefiniti per 128 Hz\n");
-            break;
-        case 100: 
-            config->hp_b = 0.99764934f; 
-            config->hp_a = 0.99529868f;
-            printf("✓ Usando coefficienti predefiniti per 100 Hz\n");
-            break;
-        case 200: 
-            config->hp_b = 0.99882329f; 
-            config->hp_a = 0.99764658f;
-            printf("✓ Usando coefficienti predefiniti per 200 Hz\n");
-            break;
-        default:
-            // Calcola coefficienti per frequenza custom
-            calculate_highpass_coefficients(fs, &config->hp_a, &config->hp_b);
-            printf("✓ Calcolati coefficienti per %d Hz (custom)\n", fs);
-            printf("  hp_a = %.8f\n", config->hp_a);
-            printf("  hp_b = %.8f\n", config->hp_b);
-            break;
+    // Frequenze standard: coefficienti e kernel precalcolati (più accurati),
+    // altrimenti calcolati
+    const StdRate *std = std_rate_find(fs);
+    if (std) {
+        config->hp_b = std->hp_b;
+        config->hp_a = std->hp_a;
+        LOG_INFO("✓ Usando coefficienti predefiniti per %d Hz\n", fs);
+    } else {
+        calculate_highpass_coefficients(fs, &config->hp_a, &config->hp_b);
+        LOG_INFO("✓ Calcolati coefficienti per %d Hz (custom)\n", fs);
+        LOG_INFO("  hp_a = %.8f\n", config->hp_a);
+        LOG_INFO("  hp_b = %.8f\n", config->hp_b);
     }
     
+    // Kernel FIR vettoriale scelto in base alla CPU
+    FirIsa isa = fir_simd_init();
+    LOG_INFO("  Kernel FIR: %s\n", fir_simd_name(isa));
+    
     // Alloca e crea kernel
     config->filter_len = 2 * fs;
     config->kernel = (float*)malloc(config->filter_len * sizeof(float));
     
-    float sum;
-    create_gaussian_kernel(config->kernel, config->filter_len, &sum);
+    if (std) {
+        memcpy(config->kernel, std->kernel, config->filter_len * sizeof(float));
+    } else {
+        float sum;
+        create_gaussian_kernel(config->kernel, config->filter_len, &sum);
+    }
+    
+    LOG_INFO("  Dimensione kernel: %d campioni (2 secondi)\n", config->filter_len);
+    
+    set_fir_prune_tolerance(config, FIR_PRUNE_TOL);
+    
+    // Coefficienti per la modalità ricorsiva (attivabile con set_fir_mode)
+    config->fir_mode = FIR_MODE_EXACT;
+    init_recursive_gaussian(&config->rg, config->kernel, config->filter_len);
+}
+
+void set_fir_prune_tolerance(FilterConfig *config, float tol) {
+    int len = config->filter_len;
+    double energy = 0.0, delay = 0.0;
+    
+    for (int k = 0; k < len; k++) {
+        energy += (double)config->kernel[k] * config->kernel[k];
+        delay += (double)k * config->kernel[k];
+    }
+    
+    // I taps a ritardo breve (k piccolo) sono la coda della gaussiana:
+    // si scartano finché l'energia rimossa resta sotto la tolleranza
+    double dropped = 0.0;
+    int offset = 0;
+    while (offset < len - 1) {
+        double e = (double)config->kernel[offset] * config->kernel[offset];
+        if (dropped + e > tol * energy) break;
+        dropped += e;
+        offset++;
+    }
     
-    printf("  Dimensione kernel: %d campioni (2 secondi)\n", config->filter_len);
+    config->prune_tol = tol;
+    config->kernel_offset = offset;
+    config->kernel_eff_len = len - offset;
+    config->group_delay = (float)delay;
+    // Il supporto arriva al ritardo filter_len-1: il primo indice calcolato
+    // resta offset + lunghezza effettiva, come nel kernel completo
+    config->fir_warmup = config->kernel_offset + config->kernel_eff_len;
+    
+    LOG_INFO("  Kernel effettivo: %d taps (offset %d, energia scartata %.1e)\n",
+             config->kernel_eff_len, config->kernel_offset,
+             energy > 0.0 ? dropped / energy : 0.0);
+    LOG_INFO("  Ritardo di gruppo: %.1f campioni, warm-up FIR: %d campioni\n",
+             config->group_delay, config->fir_warmup);
+}
+
+void set_fir_mode(FilterConfig *config, FirMode mode) {
+    config->fir_mode = mode;
+    
+    if (mode == FIR_MODE_RECURSIVE) {
+        LOG_INFO("✓ Gaussiano ricorsivo (Deriche, 4° ordine), costo costante per campione\n");
+        LOG_INFO("  Errore max vs FIR esatto: %.2e * max|ingresso|\n",
+                 config->rg.error_bound);
+    }
 }
 
 void create_gaussian_kernel(float *kernel, int len, float *sum) {
@@ -87,6 +140,11 @@ void create_gaussian_kernel(float *kernel, int len, float *sum) {
 
 void apply_highpass_filter(float *input, float *output, int n, 
                            float hp_a, float hp_b) {
+    if (scan_parallel_enabled(n)) {
+        scan_highpass(input, output, n, hp_a, hp_b);
+        return;
+    }
+    
     output[0] = 0.0f;
     for (int i = 1; i < n; i++) {
         output[i] = input[i] * hp_b - input[i-1] * hp_b + hp_a * output[i-1];
@@ -95,16 +153,187 @@ void apply_highpass_filter(float *input, float *output, int n,
 
 void apply_fir_filter(float *input, float *output, int n, 
                       float *kernel, int kernel_len) {
-    #pragma omp parallel for
-    for (int i = kernel_len; i < n; i++) {
-        float accu = 0.0f;
-        for (int k = 0; k < kernel_len; k++) {
-            accu += input[i-k] * kernel[k];
+    int block = select_fir_fft_block(n, kernel_len);
+    
+    if (block > 0) {
+        apply_fir_filter_fft(input, output, n, kernel, kernel_len, block);
+    } else {
+        apply_fir_filter_direct(input, output, n, kernel, kernel_len);
+    }
+}
+
+void apply_gaussian_smoothing(float *input, float *output, int n,
+                              FilterConfig *config) {
+    if (config->fir_mode == FIR_MODE_RECURSIVE) {
+        apply_recursive_gaussian(&config->rg, input, output, n,
+                                 config->fir_warmup);
+    } else {
+        // Kernel potato: output[i] = sum input[i-k] kernel[k], k >= offset
+        int off = config->kernel_offset;
+        apply_fir_filter(input, output + off, n - off,
+                         config->kernel + off, config->kernel_eff_len);
+    }
+}
+
+void apply_fir_filter_direct(float *input, float *output, int n, 
+                             float *kernel, int kernel_len) {
+    if (n <= kernel_len) return;
+    
+    // Blocchi multipli di 64 uscite per non spezzare i registri SIMD
+    const int chunk = FIR_DIRECT_CHUNK;
+    int n_chunks = (n - kernel_len + chunk - 1) / chunk;
+    
+    if (omp_in_parallel()) {
+        // Dentro il grafo a task: i blocchi diventano task della squadra
+        #pragma omp taskloop grainsize(1)
+        for (int c = 0; c < n_chunks; c++) {
+            int start = kernel_len + c * chunk;
+            int end = (start + chunk < n) ? start + chunk : n;
+            fir_simd_range(input, output, start, end, kernel, kernel_len);
+        }
+    } else {
+        #pragma omp parallel for schedule(static)
+        for (int c = 0; c < n_chunks; c++) {
+            int start = kernel_len + c * chunk;
+            int end = (start + chunk < n) ? start + chunk : n;
+            fir_simd_range(input, output, start, end, kernel, kernel_len);
         }
-        output[i] = accu;
     }
 }
 
+// Costo stimato per campione di uscita (in MAC equivalenti) di un blocco
+// overlap-save di lunghezza fft_len: 2 FFT reali + prodotto spettrale
+static float fft_cost_per_output(int fft_len, int kernel_len) {
+    int h = fft_len / 2;
+    int log2h = 0;
+    while ((1 << log2h) < h) log2h++;
+    
+    float per_block = 2.0f * (1.5f * h * log2h + 4.0f * h) + 3.0f * h;
+    return per_block / (fft_len - kernel_len + 1);
+}
+
+int select_fir_fft_block(int n, int kernel_len) {
+    if (kernel_len < FIR_FFT_MIN_TAPS) return 0;
+    
+    int best_len = 0;
+    // Costo convoluzione diretta: il kernel SIMD produce più uscite per MAC
+    float best_cost = (float)kernel_len / fir_simd_speedup();
+    
+    for (int len = 4; len <= FIR_FFT_MAX_BLOCK; len <<= 1) {
+        if (len < 2 * kernel_len) continue;
+        if (len - kernel_len + 1 > 2 * n) break;   // Blocco inutilmente grande
+        
+        float cost = fft_cost_per_output(len, kernel_len);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_len = len;
+        }
+    }
+    return best_len;
+}
+
+// Blocchi overlap-save [b_start, b_end) con buffer propri; 0 se manca
+// memoria (blocchi non calcolati)
+static int fir_fft_blocks(const FftPlan *plan, const float *kernel_spec,
+                          const float *input, float *output, int n,
+                          int kernel_len, int b_start, int b_end) {
+    int fft_len = plan->n;
+    int step = fft_len - kernel_len + 1;
+    int first = kernel_len;
+    float *seg = (float*)malloc(fft_len * sizeof(float));
+    float *spec = (float*)malloc((fft_len + 2) * sizeof(float));
+    if (!seg || !spec) {
+        free(seg);
+        free(spec);
+        return 0;
+    }
+    
+    for (int b = b_start; b < b_end; b++) {
+        int out_start = first + b * step;
+        int in_start = out_start - (kernel_len - 1);
+        int out_count = (n - out_start < step) ? n - out_start : step;
+        int in_count = kernel_len - 1 + out_count;
+        
+        memcpy(seg, input + in_start, in_count * sizeof(float));
+        memset(seg + in_count, 0, (fft_len - in_count) * sizeof(float));
+        
+        fft_real_forward(plan, seg, spec);
+        for (int k = 0; k <= fft_len / 2; k++) {
+            float ar = spec[2*k], ai = spec[2*k+1];
+            float br = kernel_spec[2*k], bi = kernel_spec[2*k+1];
+            spec[2*k] = ar * br - ai * bi;
+            spec[2*k+1] = ar * bi + ai * br;
+        }
+        fft_real_inverse(plan, spec, seg);
+        
+        // Le prime kernel_len-1 uscite sono aliasate (overlap-save)
+        memcpy(output + out_start, seg + kernel_len - 1,
+               out_count * sizeof(float));
+    }
+    
+    free(seg);
+    free(spec);
+    return 1;
+}
+
+void apply_fir_filter_fft(float *input, float *output, int n, 
+                          float *kernel, int kernel_len, int fft_len) {
+    int step = fft_len - kernel_len + 1;   // Uscite valide per blocco
+    int spec_len = fft_len + 2;
+    
+    FftPlan plan;
+    if (!fft_plan_init(&plan, fft_len)) {
+        apply_fir_filter_direct(input, output, n, kernel, kernel_len);
+        return;
+    }
+    
+    // Spettro del kernel (zero-padded); senza memoria si ripiega sul diretto
+    float *kernel_spec = (float*)malloc(spec_len * sizeof(float));
+    float *kernel_pad = (float*)calloc(fft_len, sizeof(float));
+    if (!kernel_spec || !kernel_pad) {
+        free(kernel_spec);
+        free(kernel_pad);
+        fft_plan_free(&plan);
+        apply_fir_filter_direct(input, output, n, kernel, kernel_len);
+        return;
+    }
+    memcpy(kernel_pad, kernel, kernel_len * sizeof(float));
+    fft_real_forward(&plan, kernel_pad, kernel_spec);
+    free(kernel_pad);
+    
+    // Prima uscita calcolata, come nel percorso diretto
+    int first = kernel_len;
+    int n_blocks = (n - first + step - 1) / step;
+    
+    int failed = 0;
+    if (omp_in_parallel()) {
+        // Dentro il grafo a task: gruppi di blocchi come task della squadra
+        int groups = 2 * omp_get_num_threads();
+        if (groups > n_blocks) groups = n_blocks;
+        #pragma omp taskloop grainsize(1) reduction(|:failed)
+        for (int g = 0; g < groups; g++) {
+            failed |= !fir_fft_blocks(&plan, kernel_spec, input, output, n,
+                                      kernel_len,
+                                      (int)((long)n_blocks * g / groups),
+                                      (int)((long)n_blocks * (g + 1) / groups));
+        }
+    } else {
+        #pragma omp parallel reduction(|:failed)
+        {
+            int t = omp_get_thread_num(), nt = omp_get_num_threads();
+            failed |= !fir_fft_blocks(&plan, kernel_spec, input, output, n,
+                                      kernel_len,
+                                      (int)((long)n_blocks * t / nt),
+                                      (int)((long)n_blocks * (t + 1) / nt));
+        }
+    }
+    
+    free(kernel_spec);
+    fft_plan_free(&plan);
+    // Buffer di blocco mancati: tutto il segnale con la convoluzione diretta
+    if (failed) apply_fir_filter_direct(input, output, n, kernel, kernel_len);
+}
+
 void cleanup_filter_config(FilterConfig *config) {
     if (config->kernel) {
         free(config->kernel);
@@ -6,17 +6,39 @@
 // Inizializza configurazione filtri
 void init_filter_config(FilterConfig *config, int fs);
 
+// Ricalcola il supporto effettivo del kernel per la tolleranza data
+void set_fir_prune_tolerance(FilterConfig *config, float tol);
+
+// Seleziona kernel esatto o approssimazione ricorsiva
+void set_fir_mode(FilterConfig *config, FirMode mode);
+
 // Crea kernel FIR gaussiano
 void create_gaussian_kernel(float *kernel, int len, float *sum);
 
-// Applica filtro high-pass
+// Applica filtro high-pass (scan parallela per record lunghi, vedi scan.h)
 void apply_highpass_filter(float *input, float *output, int n, 
                            float hp_a, float hp_b);
 
-// Applica filtro FIR
+// Applica filtro FIR (sceglie automaticamente diretto o FFT)
 void apply_fir_filter(float *input, float *output, int n, 
                       float *kernel, int kernel_len);
 
+// Applica il passa-basso gaussiano (kernel potato o ricorsivo)
+void apply_gaussian_smoothing(float *input, float *output, int n,
+                              FilterConfig *config);
+
+// Convoluzione diretta O(n*k)
+void apply_fir_filter_direct(float *input, float *output, int n, 
+                             float *kernel, int kernel_len);
+
+// Convoluzione overlap-save con FFT reale di lunghezza fft_len (senza
+// memoria per piano o buffer ripiega sulla convoluzione diretta)
+void apply_fir_filter_fft(float *input, float *output, int n, 
+                          float *kernel, int kernel_len, int fft_len);
+
+// Lunghezza blocco FFT conveniente, 0 se conviene il percorso diretto
+int select_fir_fft_block(int n, int kernel_len);
+
 // Libera risorse
 void cleanup_filter_config(FilterConfig *config);
 
@@ -0,0 +1,251 @@
+#include "fir_simd.h"
+#include "std_rates.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FIR_HAVE_X86 1
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FIR_HAVE_NEON 1
+#endif
+
+typedef void (*FirRangeFn)(const float*, float*, int, int, const float*, int);
+
+#define FIR_FIXED_COUNT 3
+static const int fir_fixed_len[FIR_FIXED_COUNT] = {
+    STD_TAPS_100, STD_TAPS_128, STD_TAPS_200
+};
+
+static FirRangeFn fir_range_impl = NULL;
+static const FirRangeFn *fir_fixed_impl = NULL;
+static FirIsa fir_isa = FIR_ISA_SCALAR;
+
+// Corpi dei kernel sempre espansi nel chiamante: le varianti a lunghezza
+// fissa (STD_TAPS_*) ricevono kernel_len costante, e il compilatore srotola
+// il loop dei tap e propaga le costanti
+#define FIR_BODY static inline __attribute__((always_inline)) void
+
+// Riferimento: stesso loop di apply_fir_filter originale
+FIR_BODY fir_body_scalar(const float *input, float *output, int start,
+                         int end, const float *kernel, int kernel_len) {
+    for (int i = start; i < end; i++) {
+        float accu = 0.0f;
+        for (int k = 0; k < kernel_len; k++) {
+            accu += input[i-k] * kernel[k];
+        }
+        output[i] = accu;
+    }
+}
+
+#ifdef FIR_HAVE_X86
+// 4 registri di uscita (32 campioni) condividono il broadcast del tap
+__attribute__((target("avx2,fma")))
+FIR_BODY fir_body_avx2(const float *input, float *output, int start,
+                       int end, const float *kernel, int kernel_len) {
+    int i = start;
+    for (; i + 32 <= end; i += 32) {
+        __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+        __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+        // Srotolato di 8 tap: broadcast e load dei tap successivi in volo
+        #pragma GCC unroll 8
+        for (int k = 0; k < kernel_len; k++) {
+            __m256 w = _mm256_broadcast_ss(kernel + k);
+            const float *p = input + i - k;
+            a0 = _mm256_fmadd_ps(_mm256_loadu_ps(p), w, a0);
+            a1 = _mm256_fmadd_ps(_mm256_loadu_ps(p + 8), w, a1);
+            a2 = _mm256_fmadd_ps(_mm256_loadu_ps(p + 16), w, a2);
+            a3 = _mm256_fmadd_ps(_mm256_loadu_ps(p + 24), w, a3);
+        }
+        _mm256_storeu_ps(output + i, a0);
+        _mm256_storeu_ps(output + i + 8, a1);
+        _mm256_storeu_ps(output + i + 16, a2);
+        _mm256_storeu_ps(output + i + 24, a3);
+    }
+    for (; i + 8 <= end; i += 8) {
+        __m256 a0 = _mm256_setzero_ps();
+        for (int k = 0; k < kernel_len; k++) {
+            a0 = _mm256_fmadd_ps(_mm256_loadu_ps(input + i - k),
+                                 _mm256_broadcast_ss(kernel + k), a0);
+        }
+        _mm256_storeu_ps(output + i, a0);
+    }
+    fir_body_scalar(input, output, i, end, kernel, kernel_len);
+}
+
+// 4 registri di uscita (64 campioni)
+__attribute__((target("avx512f")))
+FIR_BODY fir_body_avx512(const float *input, float *output, int start,
+                         int end, const float *kernel, int kernel_len) {
+    int i = start;
+    for (; i + 64 <= end; i += 64) {
+        __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps();
+        __m512 a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+        #pragma GCC unroll 8
+        for (int k = 0; k < kernel_len; k++) {
+            __m512 w = _mm512_set1_ps(kernel[k]);
+            const float *p = input + i - k;
+            a0 = _mm512_fmadd_ps(_mm512_loadu_ps(p), w, a0);
+            a1 = _mm512_fmadd_ps(_mm512_loadu_ps(p + 16), w, a1);
+            a2 = _mm512_fmadd_ps(_mm512_loadu_ps(p + 32), w, a2);
+            a3 = _mm512_fmadd_ps(_mm512_loadu_ps(p + 48), w, a3);
+        }
+        _mm512_storeu_ps(output + i, a0);
+        _mm512_storeu_ps(output + i + 16, a1);
+        _mm512_storeu_ps(output + i + 32, a2);
+        _mm512_storeu_ps(output + i + 48, a3);
+    }
+    for (; i + 16 <= end; i += 16) {
+        __m512 a0 = _mm512_setzero_ps();
+        for (int k = 0; k < kernel_len; k++) {
+            a0 = _mm512_fmadd_ps(_mm512_loadu_ps(input + i - k),
+                                 _mm512_set1_ps(kernel[k]), a0);
+        }
+        _mm512_storeu_ps(output + i, a0);
+    }
+    fir_body_scalar(input, output, i, end, kernel, kernel_len);
+}
+#endif
+
+#ifdef FIR_HAVE_NEON
+// 4 registri di uscita (16 campioni)
+FIR_BODY fir_body_neon(const float *input, float *output, int start,
+                       int end, const float *kernel, int kernel_len) {
+    int i = start;
+    for (; i + 16 <= end; i += 16) {
+        float32x4_t a0 = vdupq_n_f32(0.0f), a1 = vdupq_n_f32(0.0f);
+        float32x4_t a2 = vdupq_n_f32(0.0f), a3 = vdupq_n_f32(0.0f);
+        for (int k = 0; k < kernel_len; k++) {
+            float32x4_t w = vdupq_n_f32(kernel[k]);
+            const float *p = input + i - k;
+            a0 = vfmaq_f32(a0, vld1q_f32(p), w);
+            a1 = vfmaq_f32(a1, vld1q_f32(p + 4), w);
+            a2 = vfmaq_f32(a2, vld1q_f32(p + 8), w);
+            a3 = vfmaq_f32(a3, vld1q_f32(p + 12), w);
+        }
+        vst1q_f32(output + i, a0);
+        vst1q_f32(output + i + 4, a1);
+        vst1q_f32(output + i + 8, a2);
+        vst1q_f32(output + i + 12, a3);
+    }
+    fir_body_scalar(input, output, i, end, kernel, kernel_len);
+}
+#endif
+
+// Variante generica e varianti per le lunghezze standard di un set
+#define FIR_VARIANT(isa, attr, suffix, len)                                   \
+    attr static void fir_range_##isa##suffix(const float *input,             \
+            float *output, int start, int end, const float *kernel,         \
+            int kernel_len) {                                                \
+        (void)kernel_len;                                                    \
+        fir_body_##isa(input, output, start, end, kernel, len);              \
+    }
+#define FIR_VARIANTS(isa, attr)                                              \
+    FIR_VARIANT(isa, attr, , kernel_len)                                     \
+    FIR_VARIANT(isa, attr, _100, STD_TAPS_100)                               \
+    FIR_VARIANT(isa, attr, _128, STD_TAPS_128)                               \
+    FIR_VARIANT(isa, attr, _200, STD_TAPS_200)                               \
+    static const FirRangeFn fir_fixed_##isa[FIR_FIXED_COUNT] = {             \
+        fir_range_##isa##_100, fir_range_##isa##_128, fir_range_##isa##_200  \
+    };
+
+FIR_VARIANTS(scalar, )
+#ifdef FIR_HAVE_X86
+FIR_VARIANTS(avx2, __attribute__((target("avx2,fma"))))
+FIR_VARIANTS(avx512, __attribute__((target("avx512f"))))
+#endif
+#ifdef FIR_HAVE_NEON
+FIR_VARIANTS(neon, )
+#endif
+
+static FirIsa detect_isa(void) {
+    FirIsa best = FIR_ISA_SCALAR;
+#ifdef FIR_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        best = FIR_ISA_AVX2;
+    }
+    if (__builtin_cpu_supports("avx512f")) best = FIR_ISA_AVX512;
+#endif
+#ifdef FIR_HAVE_NEON
+    best = FIR_ISA_NEON;
+#endif
+
+    // Override per test/confronto
+    const char *env = getenv("DOSEWS_SIMD");
+    if (env) {
+        FirIsa req = best;
+        if (strcmp(env, "scalar") == 0) req = FIR_ISA_SCALAR;
+        else if (strcmp(env, "neon") == 0) req = FIR_ISA_NEON;
+        else if (strcmp(env, "avx2") == 0) req = FIR_ISA_AVX2;
+        else if (strcmp(env, "avx512") == 0) req = FIR_ISA_AVX512;
+        // Solo verso il basso: mai un set non supportato
+        if (req <= best && (req != FIR_ISA_NEON || best == FIR_ISA_NEON)) {
+            best = req;
+        }
+    }
+    return best;
+}
+
+FirIsa fir_simd_init(void) {
+    fir_isa = detect_isa();
+    switch (fir_isa) {
+#ifdef FIR_HAVE_X86
+        case FIR_ISA_AVX512:
+            fir_range_impl = fir_range_avx512;
+            fir_fixed_impl = fir_fixed_avx512;
+            break;
+        case FIR_ISA_AVX2:
+            fir_range_impl = fir_range_avx2;
+            fir_fixed_impl = fir_fixed_avx2;
+            break;
+#endif
+#ifdef FIR_HAVE_NEON
+        case FIR_ISA_NEON:
+            fir_range_impl = fir_range_neon;
+            fir_fixed_impl = fir_fixed_neon;
+            break;
+#endif
+        default:
+            fir_isa = FIR_ISA_SCALAR;
+            fir_range_impl = fir_range_scalar;
+            fir_fixed_impl = fir_fixed_scalar;
+            break;
+    }
+    return fir_isa;
+}
+
+const char* fir_simd_name(FirIsa isa) {
+    switch (isa) {
+        case FIR_ISA_AVX512: return "AVX-512";
+        case FIR_ISA_AVX2:   return "AVX2+FMA";
+        case FIR_ISA_NEON:   return "NEON";
+        default:             return "scalare";
+    }
+}
+
+float fir_simd_speedup(void) {
+    // Il loop scalare è limitato dalla latenza della somma; i kernel
+    // vettoriali con 4 accumulatori superano il numero di lane
+    switch (fir_isa) {
+        case FIR_ISA_AVX512: return 20.0f;
+        case FIR_ISA_AVX2:   return 14.0f;
+        case FIR_ISA_NEON:   return 6.0f;
+        default:             return 1.0f;
+    }
+}
+
+void fir_simd_range(const float *input, float *output, int start, int end,
+                    const float *kernel, int kernel_len) {
+    if (!fir_range_impl) fir_simd_init();
+    for (int v = 0; v < FIR_FIXED_COUNT; v++) {
+        if (kernel_len == fir_fixed_len[v]) {
+            fir_fixed_impl[v](input, output, start, end, kernel, kernel_len);
+            return;
+        }
+    }
+    fir_range_impl(input, output, start, end, kernel, kernel_len);
+}
@@ -0,0 +1,29 @@
+#ifndef FIR_SIMD_H
+#define FIR_SIMD_H
+
+typedef enum {
+    FIR_ISA_SCALAR,
+    FIR_ISA_NEON,
+    FIR_ISA_AVX2,
+    FIR_ISA_AVX512
+} FirIsa;
+
+// Seleziona il kernel migliore per la CPU (cpuid); DOSEWS_SIMD forza
+// scalar/neon/avx2/avx512. Da chiamare all'avvio, prima dei thread
+FirIsa fir_simd_init(void);
+
+// Nome leggibile del set di istruzioni
+const char* fir_simd_name(FirIsa isa);
+
+// Throughput del kernel selezionato rispetto al loop scalare (misurato,
+// usato dal modello di costo diretto/FFT)
+float fir_simd_speedup(void);
+
+// output[i] = sum_k input[i-k] * kernel[k] per i in [start, end); le
+// lunghezze STD_TAPS_* usano varianti a numero di tap costante.
+// Stesso ordine di somma del loop scalare; con FMA lo scarto è
+// |dy| <= kernel_len * 2^-24 * sum_k |input[i-k] * kernel[k]|
+void fir_simd_range(const float *input, float *output, int start, int end,
+                    const float *kernel, int kernel_len);
+
+#endif
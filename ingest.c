@@ -0,0 +1,783 @@
+#include "ingest.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+
+// Destinazione del payload di un pacchetto
+typedef enum {
+    PLACE_RING,           // Direttamente nel ring (tutti gli slot vuoti)
+    PLACE_SCRATCH,        // Slot già occupati: scratch, copia dopo la verifica
+    PLACE_PARTIAL,        // In parte già consumato: scratch, poi la coda nel ring
+    PLACE_DISCARD         // Scartato (in ritardo, oltre capacità, rifiutato)
+} PlaceMode;
+
+// Stato di uno slot del ring (0 = vuoto)
+#define SLOT_RECEIVED 1
+#define SLOT_INTERPOLATED 2       // Riempito per interpolazione, sovrascrivibile
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_sigint(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int host_is_little_endian(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t*)&probe == 1;
+}
+
+static uint64_t get_le(const uint8_t *p, int bytes) {
+    uint64_t v = 0;
+    for (int b = bytes - 1; b >= 0; b--) v = (v << 8) | p[b];
+    return v;
+}
+
+static void put_le(uint8_t *p, uint64_t v, int bytes) {
+    for (int b = 0; b < bytes; b++) {
+        p[b] = (uint8_t)(v & 0xff);
+        v >>= 8;
+    }
+}
+
+// Header serializzato campo per campo (indipendente da padding e endianness)
+static void decode_header(const uint8_t *raw, IngestHeader *h) {
+    memcpy(h->magic, raw, 4);
+    h->station = (uint16_t)get_le(raw + 4, 2);
+    h->channel = raw[6];
+    h->format = raw[7];
+    h->n_samples = (uint32_t)get_le(raw + 8, 4);
+    h->fs = (uint32_t)get_le(raw + 12, 4);
+    h->start = get_le(raw + 16, 8);
+    uint32_t s = (uint32_t)get_le(raw + 24, 4);
+    memcpy(&h->scale, &s, sizeof(float));
+}
+
+static void encode_header(const IngestHeader *h, uint8_t *raw) {
+    memset(raw, 0, INGEST_HEADER_SIZE);
+    memcpy(raw, h->magic, 4);
+    put_le(raw + 4, h->station, 2);
+    raw[6] = h->channel;
+    raw[7] = h->format;
+    put_le(raw + 8, h->n_samples, 4);
+    put_le(raw + 12, h->fs, 4);
+    put_le(raw + 16, h->start, 8);
+    uint32_t s;
+    memcpy(&s, &h->scale, sizeof(float));
+    put_le(raw + 24, s, 4);
+}
+
+int ingest_init(IngestBuffer *ib, int station, int fs) {
+    memset(ib, 0, sizeof(*ib));
+    ib->station = station;
+    ib->fs = fs;
+    ib->mask = INGEST_RING_SAMPLES - 1;
+    ib->gap_wait = (int)(INGEST_GAP_WAIT_S * fs);
+    if (ib->gap_wait < 1) ib->gap_wait = 1;
+
+    int ok = 1;
+    for (int c = 0; c < INGEST_CHANNELS; c++) {
+        ib->ch[c].data = (float*)calloc(INGEST_RING_SAMPLES, sizeof(float));
+        ib->ch[c].filled = (uint8_t*)calloc(INGEST_RING_SAMPLES, 1);
+        ok &= ib->ch[c].data && ib->ch[c].filled;
+    }
+    ib->scratch = (float*)malloc(INGEST_MAX_PACKET * sizeof(float));
+    if (!ok || !ib->scratch) {
+        ingest_free(ib);
+        return 0;
+    }
+    return 1;
+}
+
+void ingest_free(IngestBuffer *ib) {
+    for (int c = 0; c < INGEST_CHANNELS; c++) {
+        free(ib->ch[c].data);
+        free(ib->ch[c].filled);
+        ib->ch[c].data = NULL;
+        ib->ch[c].filled = NULL;
+    }
+    free(ib->scratch);
+    ib->scratch = NULL;
+}
+
+// Framing corretto: senza questo su TCP il flusso non è più allineato
+static int header_framed(const IngestHeader *h) {
+    return memcmp(h->magic, INGEST_MAGIC, 4) == 0 &&
+           h->n_samples <= INGEST_MAX_PACKET;
+}
+
+// Pacchetto destinato a questa stazione e decodificabile
+static int header_accepted(const IngestBuffer *ib, const IngestHeader *h) {
+    if (h->station != ib->station || (int)h->fs != ib->fs) return 0;
+    if (h->channel >= INGEST_CHANNELS || h->format > INGEST_FMT_END) return 0;
+    return (h->format == INGEST_FMT_END) == (h->n_samples == 0);
+}
+
+// Vero se nessuno slot di [start, start + count) del canale è occupato:
+// solo allora un pacchetto troncato o rifiutato può finire nel ring senza
+// rovinare campioni che il motore deve ancora leggere
+static int slots_empty(const IngestBuffer *ib, const IngestChannel *ch,
+                       uint64_t start, uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        if (ch->filled[(start + i) & ib->mask]) return 0;
+    }
+    return 1;
+}
+
+// Decide dove ricevere il payload e prepara gli iovec (1-2 tratti del ring
+// oppure lo scratch). Ritorna il numero di iovec scritti
+static int plan_payload(IngestBuffer *ib, const IngestHeader *h, int accepted,
+                        struct iovec *iov, PlaceMode *mode) {
+    size_t bytes = (size_t)h->n_samples * sizeof(float);
+    *mode = PLACE_DISCARD;
+
+    if (accepted && h->format != INGEST_FMT_END) {
+        if (!ib->started) {
+            // Il primo pacchetto fissa l'origine del flusso e del silenzio
+            ib->consumed = h->start;
+            ib->started = 1;
+            double now = now_ns();
+            for (int c = 0; c < INGEST_CHANNELS; c++) ib->ch[c].last_rx_ns = now;
+        }
+        uint64_t end = h->start + h->n_samples;
+        if (end <= ib->consumed) {
+            ib->stats.late++;
+        } else if (end > ib->consumed + INGEST_RING_SAMPLES) {
+            ib->stats.overflow++;
+        } else if (h->start < ib->consumed) {
+            *mode = PLACE_PARTIAL;
+        } else if (slots_empty(ib, &ib->ch[h->channel], h->start, h->n_samples)) {
+            *mode = PLACE_RING;
+        } else {
+            *mode = PLACE_SCRATCH;
+        }
+    }
+    if (bytes == 0) return 0;
+
+    if (*mode != PLACE_RING) {
+        iov[0].iov_base = ib->scratch;
+        iov[0].iov_len = bytes;
+        return 1;
+    }
+
+    float *data = ib->ch[h->channel].data;
+    uint64_t slot = h->start & ib->mask;
+    uint64_t first = INGEST_RING_SAMPLES - slot;
+    if (first >= h->n_samples) {
+        iov[0].iov_base = data + slot;
+        iov[0].iov_len = bytes;
+        return 1;
+    }
+    iov[0].iov_base = data + slot;
+    iov[0].iov_len = first * sizeof(float);
+    iov[1].iov_base = data;
+    iov[1].iov_len = bytes - iov[0].iov_len;
+    return 2;
+}
+
+// Conversione sul posto: int32 o float32 little-endian -> float m/s²
+static void decode_payload(float *v, uint64_t count, int format, float scale) {
+    int swap = !host_is_little_endian();
+    if (format == INGEST_FMT_I32) {
+        for (uint64_t i = 0; i < count; i++) {
+            uint32_t u;
+            memcpy(&u, &v[i], sizeof(u));
+            if (swap) u = __builtin_bswap32(u);
+            v[i] = (float)(int32_t)u * scale;
+        }
+    } else if (swap || scale != 1.0f) {
+        for (uint64_t i = 0; i < count; i++) {
+            if (swap) {
+                uint32_t u;
+                memcpy(&u, &v[i], sizeof(u));
+                u = __builtin_bswap32(u);
+                memcpy(&v[i], &u, sizeof(u));
+            }
+            v[i] *= scale;
+        }
+    }
+}
+
+// Registra un pacchetto ricevuto: conversione, slot pieni, statistiche
+static void commit_packet(IngestBuffer *ib, const IngestHeader *h,
+                          PlaceMode mode) {
+    ib->stats.packets++;
+    ib->stats.bytes += INGEST_HEADER_SIZE + (long)h->n_samples * sizeof(float);
+    if (!header_accepted(ib, h)) {
+        ib->stats.rejected++;
+        return;
+    }
+
+    IngestChannel *ch = &ib->ch[h->channel];
+    ch->last_rx_ns = now_ns();
+    if (ch->lost) {
+        ch->lost = 0;
+        printf("✓ Canale %s ripreso dal campione %llu\n", h->channel == 0 ? "TOP" : "BASE",
+               (unsigned long long)h->start);
+        fflush(stdout);
+    }
+    if (h->format == INGEST_FMT_END) {
+        ch->ended = 1;
+        return;
+    }
+    if (mode == PLACE_DISCARD) return;
+
+    uint64_t start = h->start, count = h->n_samples;
+    if (mode != PLACE_RING) {
+        // Dallo scratch: solo la coda non ancora consumata finisce nel ring
+        decode_payload(ib->scratch, count, h->format, h->scale);
+        uint64_t skip = (mode == PLACE_PARTIAL) ? ib->consumed - start : 0;
+        for (uint64_t i = skip; i < count; i++) {
+            ch->data[(start + i) & ib->mask] = ib->scratch[i];
+        }
+        if (mode == PLACE_PARTIAL) ib->stats.late++;
+        start += skip;
+        count -= skip;
+    } else {
+        uint64_t slot = start & ib->mask;
+        uint64_t first = INGEST_RING_SAMPLES - slot;
+        if (first > count) first = count;
+        decode_payload(ch->data + slot, first, h->format, h->scale);
+        decode_payload(ch->data, count - first, h->format, h->scale);
+    }
+
+    // Ordine di arrivo: prima del massimo già visto = fuori ordine
+    // (riempie un buco) oppure duplicato (slot già pieni)
+    if (start < ch->high && mode != PLACE_PARTIAL) {
+        int all_filled = 1;
+        for (uint64_t i = 0; i < count && all_filled; i++) {
+            all_filled = ch->filled[(start + i) & ib->mask] == SLOT_RECEIVED;
+        }
+        if (all_filled) ib->stats.duplicates++;
+        else ib->stats.out_of_order++;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        ch->filled[(start + i) & ib->mask] = SLOT_RECEIVED;
+    }
+    if (start + count > ch->high) ch->high = start + count;
+}
+
+// Riempie per interpolazione lineare il buco del canale c che inizia in k,
+// se il pacchetto mancante non può più arrivare in tempo (o con flush)
+static int fill_gap(IngestBuffer *ib, int c, uint64_t k, int flush) {
+    IngestChannel *ch = &ib->ch[c];
+    if (ch->high <= k) return 0;
+    if (!flush && !ch->ended && ch->high < k + ib->gap_wait + 1) return 0;
+
+    uint64_t j = k + 1;
+    while (j < ch->high && !ch->filled[j & ib->mask]) j++;
+    if (j >= ch->high) return 0;
+
+    float next = ch->data[j & ib->mask];
+    float span = (float)(j - k + 1);
+    for (uint64_t m = k; m < j; m++) {
+        float t = (float)(m - k + 1) / span;
+        ch->data[m & ib->mask] = ch->last + (next - ch->last) * t;
+        ch->filled[m & ib->mask] = SLOT_INTERPOLATED;
+    }
+    ib->stats.gaps++;
+    ib->stats.gap_samples += (long)(j - k);
+    return 1;
+}
+
+// Canale c fermo in k mentre un altro ha già dati oltre: dopo
+// INGEST_LOST_S di silenzio è perso e il campione k mantiene l'ultimo
+// valore, così l'analisi prosegue invece di riempire il ring dell'altro
+static int hold_lost(IngestBuffer *ib, int c, uint64_t k, double now) {
+    IngestChannel *ch = &ib->ch[c];
+    if (ch->ended || ch->high > k) return 0;
+
+    int others = 0;
+    for (int d = 0; d < INGEST_CHANNELS; d++) {
+        if (d != c && !ib->ch[d].lost && ib->ch[d].high > k) others = 1;
+    }
+    if (!others) return 0;
+
+    if (!ch->lost) {
+        double silent_s = (now - ch->last_rx_ns) / 1e9;
+        if (silent_s < INGEST_LOST_S) return 0;
+        ch->lost = 1;
+        ib->stats.lost++;
+        printf("⚠ Canale %s muto da %.1f s: perso dal campione %llu, si mantiene "
+               "l'ultimo valore\n", c == 0 ? "TOP" : "BASE", silent_s,
+               (unsigned long long)k);
+        fflush(stdout);
+    }
+    ch->data[k & ib->mask] = ch->last;
+    ch->filled[k & ib->mask] = SLOT_INTERPOLATED;
+    ib->stats.held_samples++;
+    return 1;
+}
+
+long ingest_drain(IngestBuffer *ib, StreamEngine *eng, IngestEventFn on_event,
+                  void *ctx, int flush) {
+    long pushed = 0;
+    if (!ib->started) return 0;
+    double now = now_ns();
+
+    for (;;) {
+        uint64_t slot = ib->consumed & ib->mask;
+        int ready = 1;
+        for (int c = 0; c < INGEST_CHANNELS; c++) {
+            if (!ib->ch[c].filled[slot] && !fill_gap(ib, c, ib->consumed, flush) &&
+                !hold_lost(ib, c, ib->consumed, now)) {
+                ready = 0;
+            }
+        }
+        if (!ready) break;
+
+        // I campioni passano dal ring al motore senza copie intermedie
+        StreamEvent ev;
+        int events = stream_push(eng, ib->ch[0].data[slot], ib->ch[1].data[slot],
+                                 &ev);
+        if (events && on_event) on_event(&ev, eng, ctx);
+
+        for (int c = 0; c < INGEST_CHANNELS; c++) {
+            ib->ch[c].last = ib->ch[c].data[slot];
+            ib->ch[c].filled[slot] = 0;
+        }
+        ib->consumed++;
+        pushed++;
+    }
+    return pushed;
+}
+
+// ---- Server ----
+
+static int open_server_socket(IngestProto proto, int port) {
+    int fd = socket(AF_INET, proto == INGEST_UDP ? SOCK_DGRAM : SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (proto == INGEST_UDP) {
+        // Margine per i picchi di traffico mentre l'analisi lavora
+        int rcvbuf = 4 << 20;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        (proto == INGEST_TCP && listen(fd, INGEST_MAX_CLIENTS) != 0)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Un datagramma: header letto con MSG_PEEK, poi header + payload con un
+// solo recvmsg nel ring (nello scratch se gli slot sono occupati). Ritorna 0 se non c'era nulla da leggere
+static int receive_datagram(IngestBuffer *ib, int fd) {
+    uint8_t raw[INGEST_HEADER_SIZE];
+    ssize_t r = recv(fd, raw, sizeof(raw), MSG_PEEK | MSG_DONTWAIT);
+    if (r < 0) return 0;
+
+    IngestHeader h;
+    memset(&h, 0, sizeof(h));
+    struct iovec iov[3];
+    PlaceMode mode = PLACE_DISCARD;
+    int n_iov = 0;
+
+    iov[0].iov_base = raw;
+    iov[0].iov_len = sizeof(raw);
+    if (r == INGEST_HEADER_SIZE) {
+        decode_header(raw, &h);
+        if (header_framed(&h)) {
+            n_iov = plan_payload(ib, &h, header_accepted(ib, &h), iov + 1, &mode);
+        }
+    }
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 1 + n_iov;
+    ssize_t got = recvmsg(fd, &msg, MSG_DONTWAIT);
+    if (got < 0) return 0;
+
+    if (r != INGEST_HEADER_SIZE || !header_framed(&h) || (msg.msg_flags & MSG_TRUNC) ||
+        got != INGEST_HEADER_SIZE + (ssize_t)(h.n_samples * sizeof(float))) {
+        ib->stats.packets++;
+        ib->stats.rejected++;
+        return 1;
+    }
+    commit_packet(ib, &h, mode);
+    return 1;
+}
+
+// Pacchetto TCP in arrivo su una connessione: il socket è non bloccante,
+// quindi header e payload possono arrivare in più risvegli di poll
+typedef struct {
+    int fd;
+    uint8_t raw[INGEST_HEADER_SIZE];
+    size_t have;                      // Byte già ricevuti (header + payload)
+    IngestHeader h;
+    float payload[INGEST_MAX_PACKET]; // Payload arrivato a pezzi
+} StreamConn;
+
+// Risultato di una recv non bloccante: 1 se ha letto, 0 se non c'è altro
+// per ora, -1 se la connessione va chiusa
+static int stream_recv(StreamConn *sc, void *dst, size_t len) {
+    ssize_t r = recv(sc->fd, dst, len, 0);
+    if (r > 0) {
+        sc->have += (size_t)r;
+        return 1;
+    }
+    if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+    return -1;
+}
+
+// Avanza il pacchetto della connessione con quanto è disponibile, senza
+// mai attendere. Se il payload intero è già nel socket va con un solo
+// recvmsg nel ring (o nello scratch) come per i datagrammi; se arriva a
+// pezzi si accumula nella connessione e si copia a pacchetto completo.
+// Ritorna 0 se la connessione va chiusa
+static int receive_stream_packet(IngestBuffer *ib, StreamConn *sc) {
+    if (sc->have < INGEST_HEADER_SIZE) {
+        int r = stream_recv(sc, sc->raw + sc->have, INGEST_HEADER_SIZE - sc->have);
+        if (r <= 0) return r == 0;
+        if (sc->have < INGEST_HEADER_SIZE) return 1;
+        decode_header(sc->raw, &sc->h);
+        if (!header_framed(&sc->h)) {
+            ib->stats.rejected++;
+            return 0;
+        }
+    }
+
+    const IngestHeader *h = &sc->h;
+    size_t bytes = (size_t)h->n_samples * sizeof(float);
+    size_t got = sc->have - INGEST_HEADER_SIZE;
+    struct iovec iov[2];
+    PlaceMode mode;
+
+    int avail = 0;
+    if (got == 0 && bytes > 0 && ioctl(sc->fd, FIONREAD, &avail) == 0 &&
+        (size_t)avail >= bytes) {
+        int n_iov = plan_payload(ib, h, header_accepted(ib, h), iov, &mode);
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n_iov;
+        if (recvmsg(sc->fd, &msg, 0) != (ssize_t)bytes) return 0;
+        commit_packet(ib, h, mode);
+        sc->have = 0;
+        return 1;
+    }
+
+    if (got < bytes) {
+        int r = stream_recv(sc, (uint8_t*)sc->payload + got, bytes - got);
+        if (r <= 0) return r == 0;
+        if (sc->have - INGEST_HEADER_SIZE < bytes) return 1;
+    }
+
+    int n_iov = plan_payload(ib, h, header_accepted(ib, h), iov, &mode);
+    const uint8_t *src = (const uint8_t*)sc->payload;
+    for (int i = 0; i < n_iov; i++) {
+        memcpy(iov[i].iov_base, src, iov[i].iov_len);
+        src += iov[i].iov_len;
+    }
+    commit_packet(ib, h, mode);
+    sc->have = 0;
+    return 1;
+}
+
+int run_ingest_server(IngestProto proto, int port, IngestBuffer *ib,
+                      StreamEngine *eng, IngestEventFn on_event,
+                      IngestTickFn on_tick, void *ctx) {
+    int fd = open_server_socket(proto, port);
+    if (fd < 0) {
+        printf("❌ ERRORE: Impossibile aprire la porta %d (%s)\n", port,
+               strerror(errno));
+        return 0;
+    }
+
+    // SIGINT/SIGTERM interrompono poll: si svuota il ring e si chiude il report
+    struct sigaction sa, old_int, old_term;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sigint;
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+    stop_requested = 0;
+
+    struct pollfd fds[1 + INGEST_MAX_CLIENTS];
+    StreamConn *conns = NULL;         // conns[k] è la connessione di fds[k]
+    if (proto == INGEST_TCP) {
+        conns = (StreamConn*)calloc(1 + INGEST_MAX_CLIENTS, sizeof(StreamConn));
+        if (!conns) {
+            printf("❌ ERRORE: Memoria insufficiente\n");
+            close(fd);
+            return 0;
+        }
+    }
+    int nfds = 1;
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+
+    printf("In ascolto su %s porta %d (stazione %d, %d Hz), Ctrl-C per terminare\n",
+           proto == INGEST_UDP ? "UDP" : "TCP", port, ib->station, ib->fs);
+    fflush(stdout);
+
+    while (!stop_requested && !(ib->ch[0].ended && ib->ch[1].ended)) {
+        if (on_tick) on_tick(eng, ctx);
+        int ready = poll(fds, nfds, 1000);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (proto == INGEST_UDP) {
+            if (fds[0].revents & POLLIN) {
+                // Tutti i datagrammi già in coda prima di tornare a poll
+                while (receive_datagram(ib, fd)) {
+                    if (ib->stats.packets % 64 == 0) {
+                        ingest_drain(ib, eng, on_event, ctx, 0);
+                    }
+                }
+            }
+        } else {
+            if ((fds[0].revents & POLLIN) && nfds < 1 + INGEST_MAX_CLIENTS) {
+                int client = accept(fd, NULL, NULL);
+                // Non bloccante: un client fermo a metà pacchetto non
+                // ferma gli altri né il server
+                if (client >= 0 &&
+                    fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK) == 0) {
+                    fds[nfds].fd = client;
+                    fds[nfds].events = POLLIN;
+                    fds[nfds].revents = 0;
+                    conns[nfds].fd = client;
+                    conns[nfds].have = 0;
+                    nfds++;
+                } else if (client >= 0) {
+                    close(client);
+                }
+            }
+            for (int k = 1; k < nfds; k++) {
+                if (!(fds[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                if (!receive_stream_packet(ib, &conns[k])) {
+                    close(fds[k].fd);
+                    nfds--;
+                    fds[k] = fds[nfds];
+                    conns[k] = conns[nfds];
+                    k--;
+                }
+            }
+        }
+        ingest_drain(ib, eng, on_event, ctx, 0);
+    }
+
+    // Fine trasmissione: i buchi residui non possono più essere colmati
+    ingest_drain(ib, eng, on_event, ctx, 1);
+
+    for (int k = 0; k < nfds; k++) close(fds[k].fd);
+    free(conns);
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    return 1;
+}
+
+// ---- Mittente di prova ----
+
+// Attende l'istante assoluto t (ns, CLOCK_MONOTONIC)
+static void wait_until(double t) {
+    double remaining = t - now_ns();
+    if (remaining <= 0.0) return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)(t / 1e9);
+    ts.tv_nsec = (long)(t - ts.tv_sec * 1e9);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {}
+}
+
+// Invio completo degli iovec (TCP può accettarne solo una parte)
+static int send_all(int fd, struct iovec *iov, int n_iov) {
+    while (n_iov > 0) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n_iov;
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        while (n_iov > 0 && (size_t)sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            iov++;
+            n_iov--;
+        }
+        if (n_iov > 0) {
+            iov->iov_base = (char*)iov->iov_base + sent;
+            iov->iov_len -= sent;
+        }
+    }
+    return 1;
+}
+
+typedef struct {
+    int channel;
+    int start;
+    int count;
+} PendingPacket;
+
+// Un pacchetto dal canale: float32 inviato dal buffer d'origine (host
+// little-endian), int32 convertito in conteggi da INGEST_I32_LSB
+static int send_packet(int fd, const IngestSendOptions *opt, int fs,
+                       const float *samples, float scale, int channel,
+                       int start, int count, int32_t *conv) {
+    IngestHeader h;
+    memcpy(h.magic, INGEST_MAGIC, 4);
+    h.station = (uint16_t)opt->station;
+    h.channel = (uint8_t)channel;
+    h.format = (uint8_t)opt->format;
+    h.n_samples = (uint32_t)count;
+    h.fs = (uint32_t)fs;
+    h.start = (uint64_t)start;
+    h.scale = scale;
+
+    struct iovec iov[2];
+    uint8_t raw[INGEST_HEADER_SIZE];
+    iov[0].iov_base = raw;
+    iov[0].iov_len = sizeof(raw);
+    iov[1].iov_len = (size_t)count * sizeof(float);
+
+    if (opt->format == INGEST_FMT_I32) {
+        h.scale = INGEST_I32_LSB;
+        for (int i = 0; i < count; i++) {
+            int32_t v = (int32_t)lrintf(samples[start + i] * scale / INGEST_I32_LSB);
+            uint8_t *p = (uint8_t*)&conv[i];
+            put_le(p, (uint32_t)v, 4);
+        }
+        iov[1].iov_base = conv;
+    } else if (host_is_little_endian()) {
+        iov[1].iov_base = (void*)(samples + start);
+    } else {
+        for (int i = 0; i < count; i++) {
+            uint32_t u;
+            memcpy(&u, &samples[start + i], sizeof(u));
+            put_le((uint8_t*)&conv[i], u, 4);
+        }
+        iov[1].iov_base = conv;
+    }
+    encode_header(&h, raw);
+    return send_all(fd, iov, count > 0 ? 2 : 1);
+}
+
+static int connect_to(IngestProto proto, const char *host, int port) {
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = proto == INGEST_UDP ? SOCK_DGRAM : SOCK_STREAM;
+    if (getaddrinfo(host, service, &hints, &res) != 0) return -1;
+
+    int fd = -1;
+    for (struct addrinfo *a = res; a && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+int run_ingest_sender(IngestProto proto, const char *host, int port,
+                      const float *acc_top, const float *acc_base, int n,
+                      float scale_top, float scale_base, int fs,
+                      const IngestSendOptions *opt) {
+    int fd = connect_to(proto, host, port);
+    if (fd < 0) {
+        printf("❌ ERRORE: Connessione a %s:%d fallita\n", host, port);
+        return 0;
+    }
+
+    int packet = opt->packet;
+    if (packet < 1) packet = 1;
+    if (packet > INGEST_MAX_PACKET) packet = INGEST_MAX_PACKET;
+    int32_t conv[INGEST_MAX_PACKET];
+    const float *chan[INGEST_CHANNELS] = {acc_top, acc_base};
+    float scale[INGEST_CHANNELS] = {scale_top, scale_base};
+
+    long sent = 0, dropped = 0, reordered = 0, seq = 0;
+    PendingPacket held = {-1, 0, 0};
+    int ok = 1;
+    double period = opt->speed > 0.0 ? 1e9 / (fs * opt->speed) : 0.0;
+    double t0 = now_ns();
+
+    for (int i0 = 0; i0 < n && ok; i0 += packet) {
+        int count = (n - i0 < packet) ? n - i0 : packet;
+        // Il digitalizzatore invia quando ha acquisito l'ultimo campione
+        if (period > 0.0) wait_until(t0 + (i0 + count) * period);
+
+        for (int c = 0; c < INGEST_CHANNELS && ok; c++) {
+            seq++;
+            if (opt->drop_every > 0 && seq % opt->drop_every == 0) {
+                dropped++;
+                continue;
+            }
+            if (opt->reorder_every > 0 && seq % opt->reorder_every == 0 &&
+                held.channel < 0) {
+                // Trattenuto e inviato dopo il successivo dello stesso canale
+                held = (PendingPacket){c, i0, count};
+                reordered++;
+                continue;
+            }
+            ok = send_packet(fd, opt, fs, chan[c], scale[c], c, i0, count, conv);
+            sent++;
+            if (ok && held.channel == c) {
+                ok = send_packet(fd, opt, fs, chan[held.channel],
+                                 scale[held.channel], held.channel,
+                                 held.start, held.count, conv);
+                held.channel = -1;
+                sent++;
+            }
+        }
+    }
+    if (ok && held.channel >= 0) {
+        ok = send_packet(fd, opt, fs, chan[held.channel], scale[held.channel],
+                         held.channel, held.start, held.count, conv);
+        sent++;
+    }
+
+    // Fine trasmissione per canale (ripetuta su UDP, dove può perdersi)
+    IngestSendOptions end_opt = *opt;
+    end_opt.format = INGEST_FMT_END;
+    int repeats = proto == INGEST_UDP ? 3 : 1;
+    for (int r = 0; r < repeats && ok; r++) {
+        for (int c = 0; c < INGEST_CHANNELS && ok; c++) {
+            ok = send_packet(fd, &end_opt, fs, chan[c], 1.0f, c, n, 0, conv);
+        }
+    }
+    close(fd);
+
+    printf("%s %ld pacchetti da %d campioni (%s), scartati %ld, scambiati %ld, "
+           "%.2f s\n", ok ? "✓ Inviati" : "❌ Invio interrotto dopo", sent,
+           packet, opt->format == INGEST_FMT_I32 ? "int32" : "float32",
+           dropped, reordered, (now_ns() - t0) / 1e9);
+    return ok;
+}
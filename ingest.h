@@ -0,0 +1,135 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <stdint.h>
+#include "types.h"
+#include "stream.h"
+
+// Pacchetto DOSEWS (DWSP), tutto little-endian: header da 32 byte
+//    0  magic      "DWSP"
+//    4  station    uint16   Identificativo stazione (edificio)
+//    6  channel    uint8    0 = TOP, 1 = BASE
+//    7  format     uint8    INGEST_FMT_*
+//    8  n_samples  uint32   Campioni nel payload (0 con INGEST_FMT_END)
+//   12  fs         uint32   Frequenza di campionamento (Hz)
+//   16  start      uint64   Indice del primo campione dall'avvio acquisizione
+//   24  scale      float32  Fattore verso m/s² (per campione o conteggio)
+//   28  reserved   uint32
+// seguito da n_samples valori float32 o int32. Su UDP un pacchetto per
+// datagramma, su TCP pacchetti concatenati sullo stesso flusso
+#define INGEST_MAGIC "DWSP"
+#define INGEST_HEADER_SIZE 32
+#define INGEST_MAX_PACKET 1024        // Campioni massimi per pacchetto
+#define INGEST_CHANNELS 2             // TOP, BASE
+#define INGEST_RING_SAMPLES 65536     // Capacità ring per canale (potenza di 2)
+#define INGEST_GAP_WAIT_S 0.5f        // Attesa di un pacchetto mancante (s)
+#define INGEST_LOST_S 5.0f            // Silenzio dopo cui un canale è perso (s)
+#define INGEST_MAX_CLIENTS 8          // Connessioni TCP contemporanee
+#define INGEST_I32_LSB 1e-6f          // m/s² per conteggio del mittente int32
+
+#define INGEST_FMT_F32 0
+#define INGEST_FMT_I32 1
+#define INGEST_FMT_END 2              // Fine trasmissione del canale
+
+typedef enum {
+    INGEST_UDP,
+    INGEST_TCP
+} IngestProto;
+
+typedef struct {
+    char magic[4];
+    uint16_t station;
+    uint8_t channel;
+    uint8_t format;
+    uint32_t n_samples;
+    uint32_t fs;
+    uint64_t start;
+    float scale;
+} IngestHeader;
+
+// Ring di un canale indicizzato per numero di campione: il payload viene
+// ricevuto direttamente nella sua posizione (slot = indice & mask) e
+// convertito sul posto in m/s²
+typedef struct {
+    float *data;
+    uint8_t *filled;          // Slot pronto: ricevuto o interpolato
+    uint64_t high;            // Indice più alto ricevuto + 1
+    float last;               // Ultimo valore passato all'analisi
+    int ended;                // Ricevuto INGEST_FMT_END
+    int lost;                 // Muto oltre INGEST_LOST_S: si mantiene last
+    double last_rx_ns;        // Ultimo pacchetto ricevuto (CLOCK_MONOTONIC)
+} IngestChannel;
+
+typedef struct {
+    long packets;
+    long bytes;
+    long gaps;                // Buchi riempiti per interpolazione
+    long gap_samples;
+    long out_of_order;        // Pacchetti arrivati dopo uno successivo
+    long duplicates;
+    long late;                // Arrivati dopo il consumo: scartati
+    long rejected;            // Header non validi, stazione o fs diversi
+    long overflow;            // Oltre la capacità del ring
+    long lost;                // Canali dichiarati persi
+    long held_samples;        // Campioni mantenuti di un canale perso
+} IngestStats;
+
+typedef struct {
+    int station;
+    int fs;
+    IngestChannel ch[INGEST_CHANNELS];
+    uint64_t mask;            // INGEST_RING_SAMPLES - 1
+    uint64_t consumed;        // Prossimo campione da passare all'analisi
+    int started;              // consumed fissato dal primo pacchetto
+    int gap_wait;             // Campioni di attesa prima di dichiarare un buco
+    float *scratch;           // Solo per pacchetti scartati o in ritardo
+    IngestStats stats;
+} IngestBuffer;
+
+// Chiamata per ogni evento del motore streaming
+typedef void (*IngestEventFn)(const StreamEvent *ev, const StreamEngine *eng,
+                              void *ctx);
+
+// Chiamata dal server tra due ricezioni, a campioni già consegnati
+typedef void (*IngestTickFn)(StreamEngine *eng, void *ctx);
+
+// Alloca i ring dei canali
+int ingest_init(IngestBuffer *ib, int station, int fs);
+
+// Libera i ring
+void ingest_free(IngestBuffer *ib);
+
+// Passa all'analisi i campioni completi su entrambi i canali, leggendoli
+// dal ring; con flush riempie anche i buchi senza attendere. Un canale
+// muto da INGEST_LOST_S mentre l'altro avanza viene dichiarato perso e
+// mantiene l'ultimo valore finché non riprende. Ritorna il numero di
+// campioni consumati
+long ingest_drain(IngestBuffer *ib, StreamEngine *eng, IngestEventFn on_event,
+                  void *ctx, int flush);
+
+// Server UDP o TCP sulla porta: riceve fino a INGEST_FMT_END su entrambi
+// i canali (o SIGINT/SIGTERM) e alimenta il motore streaming. on_tick
+// (facoltativa) gira a ogni risveglio, anche per un segnale. Ritorna 0 su
+// errore
+int run_ingest_server(IngestProto proto, int port, IngestBuffer *ib,
+                      StreamEngine *eng, IngestEventFn on_event,
+                      IngestTickFn on_tick, void *ctx);
+
+// Opzioni del mittente di prova
+typedef struct {
+    double speed;             // Velocità rispetto al tempo reale (0 = senza pausa)
+    int packet;               // Campioni per pacchetto
+    int format;               // INGEST_FMT_F32 o INGEST_FMT_I32
+    int station;
+    int drop_every;           // Scarta un pacchetto ogni N (0 = mai)
+    int reorder_every;        // Scambia un pacchetto ogni N col successivo
+} IngestSendOptions;
+
+// Mittente di prova (digitalizzatore simulato): invia i due canali in
+// pacchetti al ritmo di fs * speed. scale_*: fattore verso m/s² dei valori
+int run_ingest_sender(IngestProto proto, const char *host, int port,
+                      const float *acc_top, const float *acc_base, int n,
+                      float scale_top, float scale_base, int fs,
+                      const IngestSendOptions *opt);
+
+#endif
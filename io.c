@@ -1,43 +1,630 @@
 #include "io.h"
 #include "config.h"
+#include "waveform.h"
+#include "signal_processing.h"
+#include "filter_cache.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <float.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+#include <math.h>
+#include <pthread.h>
 
-int read_acceleration_file(const char *filename, float *data, 
-                           int max_samples, float unit_conversion) {
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
-        printf("ERRORE: Impossibile aprire %s\n", filename);
+#define PARSE_CHUNK_MIN (64 * 1024)   // Byte minimi per blocco parallelo
+
+typedef struct {
+    const char *begin, *end;  // Blocco allineato a fine riga
+    float *values;
+    int count;
+    long lines;               // Righe complete nel blocco (o fino all'errore)
+    const char *bad;          // Primo token non valido, NULL se nessuno
+} ParseChunk;
+
+static int is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Parsing di un token numerico indipendente dal locale. Il percorso veloce
+// produce lo stesso float di strtof (arrotondamento corretto): operazione
+// esatta in float, oppure in double quando il risultato non cade su un
+// punto medio tra due float; gli altri casi passano a strtof.
+static int parse_float_token(const char *p, const char *end, float *out) {
+    const char *start = p;
+    int negative = 0;
+    
+    if (p < end && (*p == '+' || *p == '-')) negative = (*p++ == '-');
+    
+    uint64_t mant = 0;
+    int n_digits = 0, any_digit = 0, exp10 = 0, exact = 1;
+    
+    while (p < end && *p >= '0' && *p <= '9') {
+        any_digit = 1;
+        if (mant || *p != '0') {
+            if (n_digits < 19) { mant = mant * 10 + (*p - '0'); n_digits++; }
+            else { exact = 0; }
+            if (n_digits >= 19 && !exact) exp10++;
+        }
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            any_digit = 1;
+            if (mant || *p != '0') {
+                if (n_digits < 19) { mant = mant * 10 + (*p - '0'); n_digits++; exp10--; }
+                else { exact = 0; }
+            } else {
+                exp10--;
+            }
+            p++;
+        }
+    }
+    if (any_digit && p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int exp_neg = 0, e = 0, exp_digits = 0;
+        if (q < end && (*q == '+' || *q == '-')) exp_neg = (*q++ == '-');
+        while (q < end && *q >= '0' && *q <= '9') {
+            if (e < 10000) e = e * 10 + (*q - '0');
+            exp_digits++;
+            q++;
+        }
+        if (exp_digits) {
+            exp10 += exp_neg ? -e : e;
+            p = q;
+        }
+    }
+    
+    if (any_digit && p == end && exact) {
+        static const float pow10f_tab[] = {
+            1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+        };
+        static const double pow10_tab[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        
+        if (mant == 0) {
+            *out = negative ? -0.0f : 0.0f;
+            return 1;
+        }
+        if (mant < (1u << 24) && exp10 >= -10 && exp10 <= 10) {
+            float v = (float)mant;
+            v = (exp10 >= 0) ? v * pow10f_tab[exp10] : v / pow10f_tab[-exp10];
+            *out = negative ? -v : v;
+            return 1;
+        }
+        if (mant < (1ull << 53) && exp10 >= -22 && exp10 <= 22) {
+            double d = (double)mant;
+            d = (exp10 >= 0) ? d * pow10_tab[exp10] : d / pow10_tab[-exp10];
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            if ((bits & 0x1fffffffull) != 0x10000000ull &&
+                d >= FLT_MIN && d <= FLT_MAX) {
+                *out = negative ? -(float)d : (float)d;
+                return 1;
+            }
+        }
+    }
+    
+    // Casi rari (inf/nan, hex, molte cifre, punti medi): strtof sul token
+    char buf[128];
+    size_t len = (size_t)(end - start);
+    if (len == 0 || len >= sizeof(buf)) return 0;
+    memcpy(buf, start, len);
+    buf[len] = '\0';
+    char *stop;
+    float v = strtof(buf, &stop);
+    if (stop != buf + len) return 0;
+    *out = v;
+    return 1;
+}
+
+static void parse_chunk(ParseChunk *c, int max_values) {
+    const char *p = c->begin;
+    c->count = 0;
+    c->lines = 0;
+    c->bad = NULL;
+    
+    while (p < c->end && c->count < max_values) {
+        while (p < c->end && is_space(*p)) {
+            if (*p == '\n') c->lines++;
+            p++;
+        }
+        if (p >= c->end) break;
+        
+        const char *tok = p;
+        while (p < c->end && !is_space(*p)) p++;
+        
+        if (!parse_float_token(tok, p, &c->values[c->count])) {
+            c->bad = tok;
+            return;
+        }
+        c->count++;
+    }
+}
+
+// Contenuto del file: mappato se possibile, altrimenti letto in memoria
+static char* load_text(const char *filename, size_t *size, int *mapped) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            close(fd);
+            *size = st.st_size;
+            *mapped = 1;
+            return (char*)map;
+        }
+    }
+    
+    size_t cap = 1 << 16, len = 0;
+    char *buf = (char*)malloc(cap);
+    ssize_t r;
+    while (buf && (r = read(fd, buf + len, cap - len)) > 0) {
+        len += r;
+        if (len == cap) {
+            char *grown = (char*)realloc(buf, cap * 2);
+            if (!grown) { free(buf); buf = NULL; break; }
+            buf = grown;
+            cap *= 2;
+        }
+    }
+    close(fd);
+    *size = len;
+    *mapped = 0;
+    return buf;
+}
+
+// Alloca i valori del blocco e lo analizza; 0 se manca memoria
+static int parse_chunk_alloc(ParseChunk *chunk, int max_samples) {
+    // Un valore occupa almeno 2 byte (cifra + separatore)
+    size_t cap = (size_t)(chunk->end - chunk->begin) / 2 + 1;
+    if (cap > (size_t)max_samples) cap = max_samples;
+    chunk->values = (float*)malloc(cap * sizeof(float));
+    if (!chunk->values) return 0;
+    parse_chunk(chunk, (int)cap);
+    return 1;
+}
+
+// Copia i valori del blocco nella destinazione convertendo l'unità
+static void store_chunk(const ParseChunk *chunk, float *dst, float unit_conversion) {
+    #pragma omp simd
+    for (int i = 0; i < chunk->count; i++) {
+        dst[i] = chunk->values[i] * unit_conversion;
+    }
+}
+
+// Analizza il testo già in memoria. Con sized != NULL i valori finiscono in
+// sized->acc, dimensionato sul numero di campioni letti; altrimenti in data
+// (almeno max_samples)
+static int parse_acceleration(const char *filename, const char *text, size_t size,
+                              float *data, SignalData *sized,
+                              int max_samples, float unit_conversion) {
+    // Blocchi allineati a fine riga, uno o più per thread
+    int n_chunks = omp_get_max_threads() * 4;
+    if ((size_t)n_chunks > size / PARSE_CHUNK_MIN + 1) {
+        n_chunks = (int)(size / PARSE_CHUNK_MIN) + 1;
+    }
+    ParseChunk *chunks = (ParseChunk*)calloc(n_chunks, sizeof(ParseChunk));
+    if (!chunks) {
+        printf("ERRORE: Memoria insufficiente leggendo %s\n", filename);
         return -1;
     }
     
+    const char *cursor = text, *text_end = text + size;
+    for (int c = 0; c < n_chunks; c++) {
+        const char *end = (c == n_chunks - 1) ? text_end : text + size * (c + 1) / n_chunks;
+        if (end < cursor) end = cursor;
+        while (end < text_end && end[-1] != '\n') end++;
+        chunks[c].begin = cursor;
+        chunks[c].end = end;
+        cursor = end;
+    }
+    
+    int failed = 0;
+    if (omp_in_parallel()) {
+        // Dentro il grafo a task: i blocchi diventano task della squadra
+        #pragma omp taskloop grainsize(1) reduction(|:failed)
+        for (int c = 0; c < n_chunks; c++) {
+            failed |= !parse_chunk_alloc(&chunks[c], max_samples);
+        }
+    } else {
+        #pragma omp parallel for schedule(dynamic, 1) reduction(|:failed)
+        for (int c = 0; c < n_chunks; c++) {
+            failed |= !parse_chunk_alloc(&chunks[c], max_samples);
+        }
+    }
+    
+    // Ordine del file: ci si ferma al primo token non valido
     int count = 0;
-    float temp;
-    while (count < max_samples && fscanf(fp, "%f", &temp) == 1) {
-        data[count] = temp * unit_conversion;
-        count++;
+    long line = 1;
+    int offsets[n_chunks];
+    int last = n_chunks - 1;
+    for (int c = 0; c < n_chunks && !failed; c++) {
+        offsets[c] = count;
+        int take = chunks[c].count;
+        if (count + take > max_samples) take = max_samples - count;
+        chunks[c].count = take;
+        count += take;
+        
+        if (count >= max_samples) { last = c; break; }
+        if (chunks[c].bad) {
+            const char *tok_end = chunks[c].bad;
+            while (tok_end < chunks[c].end && !is_space(*tok_end) &&
+                   tok_end - chunks[c].bad < 32) tok_end++;
+            printf("ERRORE: %s riga %ld: valore non valido '%.*s', "
+                   "lettura interrotta dopo %d campioni\n",
+                   filename, line + chunks[c].lines,
+                   (int)(tok_end - chunks[c].bad), chunks[c].bad, count);
+            last = c;
+            break;
+        }
+        line += chunks[c].lines;
+    }
+    
+    if (!failed && sized) {
+        if (reserve_signal_data(sized, count)) data = sized->acc;
+        else failed = 1;
+    }
+    
+    if (!failed) {
+        // Copia e conversione di unità in un'unica passata per blocco
+        if (omp_in_parallel()) {
+            #pragma omp taskloop grainsize(1)
+            for (int c = 0; c <= last; c++) {
+                store_chunk(&chunks[c], data + offsets[c], unit_conversion);
+            }
+        } else {
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int c = 0; c <= last; c++) {
+                store_chunk(&chunks[c], data + offsets[c], unit_conversion);
+            }
+        }
+    } else {
+        printf("ERRORE: Memoria insufficiente leggendo %s\n", filename);
+        count = -1;
     }
     
-    fclose(fp);
+    for (int c = 0; c < n_chunks; c++) free(chunks[c].values);
+    free(chunks);
     return count;
 }
 
-void write_results(const char *filename, SignalData *top, SignalData *base,
-                   float *drift, float *drift_norm, int n,
-                   float dt, int alarm_idx) {
-    FILE *fp = fopen(filename, "w");
-    if (!fp) return;
+static void release_text(char *text, size_t size, int mapped) {
+    if (mapped) munmap(text, size);
+    else free(text);
+}
+
+static int read_acceleration(const char *filename, float *data, SignalData *sized,
+                             int max_samples, float unit_conversion) {
+    size_t size = 0;
+    int mapped = 0;
+    char *text = load_text(filename, &size, &mapped);
+    if (!text) {
+        printf("ERRORE: Impossibile aprire %s\n", filename);
+        return -1;
+    }
+    int count = parse_acceleration(filename, text, size, data, sized,
+                                   max_samples, unit_conversion);
+    release_text(text, size, mapped);
+    return count;
+}
+
+int read_acceleration_file(const char *filename, float *data, 
+                           int max_samples, float unit_conversion) {
+    return read_acceleration(filename, data, NULL, max_samples, unit_conversion);
+}
+
+// Collega il canale di un .dwsf già mappato in wf
+static int attach_waveform_channel(const char *filename, int channel,
+                                   SignalData *data, WaveformFile *wf, int fs) {
+    const float *samples = waveform_channel(wf, channel);
+    if (!samples) {
+        printf("ERRORE: %s non contiene il canale %d\n", filename, channel);
+        waveform_close(wf);
+        return -1;
+    }
+    if ((int)wf->hdr.fs != fs) {
+        printf("⚠ ATTENZIONE: %s dichiara %u Hz, configurati %d Hz\n",
+               filename, wf->hdr.fs, fs);
+    }
+    
+    int n = (wf->hdr.n_samples > MAX_SAMPLES) ? MAX_SAMPLES : (int)wf->hdr.n_samples;
+    if (!reserve_signal_data(data, n)) {
+        printf("ERRORE: Memoria insufficiente per %s\n", filename);
+        waveform_close(wf);
+        return -1;
+    }
+    attach_external_acc(data, samples, waveform_unit_scale(wf));
+    LOG_INFO("✓ %s mappato: canale %d, %s\n", filename, channel,
+             wf->hdr.unit == WAVEFORM_UNIT_G ? "g" : "m/s²");
+    
+    return n;
+}
+
+// Carica un canale: testo (unità convertita in lettura) oppure .dwsf
+// mappato senza copia (unità assorbita nel filtro HP)
+int load_channel(const char *filename, int channel, SignalData *data,
+                 WaveformFile *wf, float unit_conv, int fs) {
+    detach_external_acc(data);
+    if (!waveform_is_binary_name(filename)) {
+        return read_acceleration(filename, NULL, data, MAX_SAMPLES, unit_conv);
+    }
+    if (!waveform_open(wf, filename)) return -1;
+    return attach_waveform_channel(filename, channel, data, wf, fs);
+}
+
+int open_channel_source(ChannelSource *src, const char *filename,
+                        WaveformFile *wf) {
+    memset(src, 0, sizeof(*src));
+    src->filename = filename;
+    if (waveform_is_binary_name(filename)) {
+        if (!waveform_open(wf, filename)) return 0;
+        src->hash = filter_cache_hash(wf->map, wf->map_len);
+        return 1;
+    }
+    src->text = load_text(filename, &src->size, &src->mapped);
+    if (!src->text) {
+        printf("ERRORE: Impossibile aprire %s\n", filename);
+        return 0;
+    }
+    src->hash = filter_cache_hash(src->text, src->size);
+    return 1;
+}
+
+int load_channel_source(const ChannelSource *src, int channel, SignalData *data,
+                        WaveformFile *wf, float unit_conv, int fs) {
+    detach_external_acc(data);
+    if (!src->text) return attach_waveform_channel(src->filename, channel, data, wf, fs);
+    return parse_acceleration(src->filename, src->text, src->size, NULL, data,
+                              MAX_SAMPLES, unit_conv);
+}
+
+void close_channel_source(ChannelSource *src) {
+    if (src->text) release_text(src->text, src->size, src->mapped);
+    src->text = NULL;
+}
+
+// ---- Scrittura risultati ----
+
+#define RESULTS_BUF_SIZE (1 << 20)    // Buffer di formattazione (1 MB)
+#define RESULTS_ROW_MAX 160           // Spazio massimo per una riga CSV
+
+typedef unsigned __int128 u128;
+
+static u128 pow10_u128(int k) {
+    static const uint64_t p[20] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+        10000000ull, 100000000ull, 1000000000ull, 10000000000ull,
+        100000000000ull, 1000000000000ull, 10000000000000ull,
+        100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+        100000000000000000ull, 1000000000000000000ull,
+        10000000000000000000ull
+    };
+    return (k <= 19) ? (u128)p[k] : (u128)p[19] * p[k - 19];
+}
+
+// |v| * 10^s arrotondato all'intero (metà al pari, come printf).
+// Calcolo esatto su 128 bit; ritorna 0 se fuori dall'intervallo gestito
+static int scale_round(uint32_t m, int e2, int s, uint64_t *out) {
+    u128 q;
+    int cmp;
     
-    fprintf(fp, "# Indice, Tempo(s), Drift_abs(m), Drift_norm(mm/m), "
-                "Disp_TOP(m), Disp_BASE(m), Allarme\n");
+    if (s < -30 || s > 30) return 0;
+    if (s >= 0) {
+        u128 num = (u128)m * pow10_u128(s);        // < 2^124
+        if (e2 >= 0) {
+            if (e2 > 100 || (num >> (127 - e2)) != 0) return 0;
+            q = num << e2;
+            cmp = -1;
+        } else if (-e2 >= 126) {
+            q = 0;                                  // num < 2^124 < metà
+            cmp = -1;
+        } else {
+            int sh = -e2;
+            u128 rem = num & (((u128)1 << sh) - 1);
+            u128 half = (u128)1 << (sh - 1);
+            q = num >> sh;
+            cmp = (rem > half) - (rem < half);
+        }
+    } else {
+        if (e2 < 0 || e2 > 100) return 0;
+        u128 num = (u128)m << e2;
+        u128 den = pow10_u128(-s);
+        u128 rem = num % den;
+        q = num / den;
+        cmp = (2 * rem > den) - (2 * rem < den);
+    }
+    if (cmp > 0 || (cmp == 0 && (q & 1))) q++;
+    if (q >> 63) return 0;
+    *out = (uint64_t)q;
+    return 1;
+}
+
+static void split_float(float v, uint32_t *m, int *e2, int *neg) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    *neg = bits >> 31;
+    int be = (bits >> 23) & 0xff;
+    *m = bits & 0x7fffff;
+    if (be == 0) {
+        *e2 = -149;
+    } else {
+        *m |= 1u << 23;
+        *e2 = be - 150;
+    }
+}
+
+static char* put_uint(char *p, uint64_t v, int min_digits) {
+    char tmp[20];
+    int len = 0;
+    do {
+        tmp[len++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v || len < min_digits);
+    while (len) *p++ = tmp[--len];
+    return p;
+}
+
+// Equivalente a "%.6f" per un float
+static char* put_fixed6(char *p, float v) {
+    uint32_t m;
+    int e2, neg;
+    uint64_t q;
+    split_float(v, &m, &e2, &neg);
+    if (!isfinite(v) || fabsf(v) >= 1e12f || !scale_round(m, e2, 6, &q)) {
+        return p + sprintf(p, "%.6f", v);
+    }
+    if (neg) *p++ = '-';
+    p = put_uint(p, q / 1000000, 1);
+    *p++ = '.';
+    return put_uint(p, q % 1000000, 6);
+}
+
+// Equivalente a "%.8e" per un float
+static char* put_exp8(char *p, float v) {
+    uint32_t m;
+    int e2, neg;
+    uint64_t d = 0;
+    split_float(v, &m, &e2, &neg);
+    if (!isfinite(v)) return p + sprintf(p, "%.8e", v);
     
-    for (int i = 0; i < n; i++) {
-        char alarm_flag = (i == alarm_idx) ? 'R' : ' ';
-        fprintf(fp, "%d, %.6f, %.8e, %.6f, %.8e, %.8e, %c\n",
-                i+1, i*dt, drift[i], drift_norm[i] * 1000,
-                top->disp[i], base->disp[i], alarm_flag);
+    int e10 = 0;
+    if (m != 0) {
+        e10 = (int)floor(log10(fabs((double)v)));
+        int ok = scale_round(m, e2, 8 - e10, &d);
+        // Correzione della stima del log10 (al più un passo)
+        if (ok && d >= 1000000000ull) ok = scale_round(m, e2, 8 - ++e10, &d);
+        else if (ok && d < 100000000ull) ok = scale_round(m, e2, 8 - --e10, &d);
+        if (!ok || d < 100000000ull || d > 1000000000ull) {
+            return p + sprintf(p, "%.8e", v);
+        }
+        if (d == 1000000000ull) {
+            d = 100000000ull;
+            e10++;
+        }
+    }
+    
+    if (neg) *p++ = '-';
+    char digits[9];
+    put_uint(digits, d, 9);
+    *p++ = digits[0];
+    *p++ = '.';
+    memcpy(p, digits + 1, 8);
+    p += 8;
+    *p++ = 'e';
+    *p++ = (e10 < 0) ? '-' : '+';
+    return put_uint(p, (uint64_t)abs(e10), 2);
+}
+
+static int write_results_csv(ResultsWriter *w) {
+    FILE *fp = fopen(w->filename, "w");
+    if (!fp) return 0;
+    
+    char *buf = (char*)malloc(RESULTS_BUF_SIZE);
+    if (!buf) {
+        fclose(fp);
+        return 0;
+    }
+    
+    int len = snprintf(buf, RESULTS_BUF_SIZE,
+                       "# Indice, Tempo(s), Drift_abs(m), Drift_norm(mm/m), "
+                       "Disp_TOP(m), Disp_BASE(m), Allarme\n");
+    char *p = buf + len;
+    int ok = 1;
+    
+    for (int i = w->start; i < w->end && ok; i++) {
+        float drift = w->disp_top[i] - w->disp_base[i];
+        float drift_norm = drift / w->norm_height;
+        
+        p = put_uint(p, (uint64_t)(i + 1), 1);
+        *p++ = ','; *p++ = ' ';
+        p = put_fixed6(p, i * w->dt);
+        *p++ = ','; *p++ = ' ';
+        p = put_exp8(p, drift);
+        *p++ = ','; *p++ = ' ';
+        p = put_fixed6(p, drift_norm * 1000);
+        *p++ = ','; *p++ = ' ';
+        p = put_exp8(p, w->disp_top[i]);
+        *p++ = ','; *p++ = ' ';
+        p = put_exp8(p, w->disp_base[i]);
+        *p++ = ','; *p++ = ' ';
+        *p++ = (i == w->alarm_idx) ? 'R' : ' ';
+        *p++ = '\n';
+        
+        if (p - buf > RESULTS_BUF_SIZE - RESULTS_ROW_MAX) {
+            ok = fwrite(buf, 1, p - buf, fp) == (size_t)(p - buf);
+            p = buf;
+        }
     }
+    if (ok && p > buf) ok = fwrite(buf, 1, p - buf, fp) == (size_t)(p - buf);
     
-    fclose(fp);
+    free(buf);
+    if (fclose(fp) != 0) ok = 0;
+    return ok;
+}
+
+// Colonne: drift (m), drift norm. (mm/m), disp TOP, disp BASE, allarme (0/1)
+static int write_results_binary(ResultsWriter *w) {
+    long rows = w->end - w->start;
+    float *cols = (float*)malloc(5 * (rows > 0 ? rows : 1) * sizeof(float));
+    if (!cols) return 0;
+    
+    float *drift = cols, *drift_norm = cols + rows;
+    float *disp_top = cols + 2 * rows, *disp_base = cols + 3 * rows;
+    float *alarm = cols + 4 * rows;
+    for (long r = 0; r < rows; r++) {
+        int i = w->start + r;
+        drift[r] = w->disp_top[i] - w->disp_base[i];
+        drift_norm[r] = drift[r] / w->norm_height * 1000;
+        disp_top[r] = w->disp_top[i];
+        disp_base[r] = w->disp_base[i];
+        alarm[r] = (i == w->alarm_idx) ? 1.0f : 0.0f;
+    }
+    
+    const float *channels[5] = {drift, drift_norm, disp_top, disp_base, alarm};
+    int ok = waveform_write(w->filename, w->fs, WAVEFORM_UNIT_MS2,
+                            w->start * (double)w->dt, channels, 5, rows);
+    free(cols);
+    return ok;
+}
+
+static void* results_thread(void *arg) {
+    ResultsWriter *w = (ResultsWriter*)arg;
+    w->ok = (w->format == RESULTS_BINARY) ? write_results_binary(w)
+                                           : write_results_csv(w);
+    return NULL;
+}
+
+int write_results(ResultsWriter *w, int async) {
+    w->running = 0;
+    w->ok = 0;
+    if (w->start < 0) w->start = 0;
+    if (w->end < w->start) w->end = w->start;
+    
+    if (async && pthread_create(&w->thread, NULL, results_thread, w) == 0) {
+        w->running = 1;
+        return 1;
+    }
+    results_thread(w);
+    return w->ok;
+}
+
+int wait_results(ResultsWriter *w) {
+    if (w->running) {
+        pthread_join(w->thread, NULL);
+        w->running = 0;
+    }
+    return w->ok;
 }
 
 void print_input_statistics(int n_samples, float dt, 
@@ -63,4 +650,169 @@ void print_final_report(AnalysisResults *results, AlarmThreshold *threshold) {
             printf("  Probabilità vicina alla soglia\n");
         }
     }
-}
\ No newline at end of file
+}
+
+// ---- Matrice di fragilità ----
+
+extern const char *building_keys[];
+extern const char *damage_keys[];
+
+void print_fragility_matrix(const FragilityMatrix *m, float dt) {
+    printf("\n========== MATRICE DI FRAGILITÀ ==========\n");
+    printf("PGD base: %.5f m (finestra fino a T+%.2fs)\n", m->pgd_base,
+           (m->end - 1 - m->start) * dt);
+    printf("%-17s %-9s %7s %8s %10s %8s  %s\n", "Edificio", "Danno",
+           "Drift", "Soglia%", "PGD crit.", "P(%)", "Allarme");
+    
+    int n_alarm = 0;
+    for (int k = 0; k < m->n; k++) {
+        const AlarmThreshold *t = &m->table[k];
+        printf("%-17s %-9s %7.4f %8.2f %10.5f %8.2f  ",
+               building_keys[t->type], damage_keys[t->state], t->drift_limit,
+               t->prob_threshold, m->pgd_critical[k], m->prob[k] * 100.0f);
+        if (m->crossing_idx[k] >= 0) {
+            printf("T+%.3fs\n", (m->crossing_idx[k] - m->start) * dt);
+            n_alarm++;
+        } else {
+            printf("-\n");
+        }
+    }
+    printf("Soglie superate: %d su %d\n", n_alarm, m->n);
+}
+
+int write_fragility_csv(const char *filename, const FragilityMatrix *m,
+                        float dt) {
+    FILE *fp = fopen(filename, "w");
+    if (!fp) return 0;
+    
+    fprintf(fp, "# Edificio, Danno, Drift_limite, Prob_soglia(%%), PGD_critico(m), "
+                "Prob(%%), Allarme, Indice_allarme, T_allarme(s)\n");
+    for (int k = 0; k < m->n; k++) {
+        const AlarmThreshold *t = &m->table[k];
+        int idx = m->crossing_idx[k];
+        fprintf(fp, "%s, %s, %.4f, %.2f, %.6e, %.2f, %d, %d, %.3f\n",
+                building_keys[t->type], damage_keys[t->state], t->drift_limit,
+                t->prob_threshold, m->pgd_critical[k], m->prob[k] * 100.0f,
+                idx >= 0, idx >= 0 ? idx + 1 : 0,
+                idx >= 0 ? (idx - m->start) * dt : 0.0f);
+    }
+    return fclose(fp) == 0;
+}
+
+// ---- Banco di rivelatori ----
+
+void print_trigger_bank(const TriggerBankResult *r, const TriggerBankParams *bank,
+                        float dt) {
+    printf("\n========== BANCO RIVELATORI ==========\n");
+    printf("Finestre: STA=%.1fs, LTA=%.1fs, kurtosis=%.1fs\n",
+           bank->sta_s, bank->lta_s, bank->kurt_s);
+    printf("%-10s %7s %10s %9s %10s %9s\n", "Rivelatore", "Soglia",
+           "Pick (s)", "Valore", "Max (s)", "Max");
+    for (int d = 0; d < DETECTOR_COUNT; d++) {
+        printf("%-10s %7.2f ", detector_name((DetectorType)d), bank->threshold[d]);
+        if (r->pick_idx[d] >= 0) {
+            printf("%10.3f %9.2f ", r->pick_idx[d] * dt, r->pick_value[d]);
+        } else {
+            printf("%10s %9s ", "-", "-");
+        }
+        if (r->max_idx[d] >= 0) {
+            printf("%10.3f %9.2f\n", r->max_idx[d] * dt, r->max_value[d]);
+        } else {
+            printf("%10s %9s\n", "-", "-");
+        }
+    }
+}
+
+int write_trigger_bank_csv(const char *filename, const TriggerBankResult *r,
+                           float dt) {
+    if (!r->trace) return 0;
+    FILE *fp = fopen(filename, "w");
+    if (!fp) return 0;
+    
+    char *buf = (char*)malloc(RESULTS_BUF_SIZE);
+    if (buf) setvbuf(fp, buf, _IOFBF, RESULTS_BUF_SIZE);
+    
+    fprintf(fp, "# Indice, Tempo(s), STA/LTA, Ricorsivo, Z, Kurtosis\n");
+    for (int i = r->first; i < r->n; i++) {
+        const float *row = r->trace + (size_t)(i - r->first) * DETECTOR_COUNT;
+        fprintf(fp, "%d, %.4f, %.4f, %.4f, %.4f, %.4f\n", i + 1, i * dt,
+                row[0], row[1], row[2], row[3]);
+    }
+    int ok = fclose(fp) == 0;
+    free(buf);
+    return ok;
+}
+
+// ---- Replay in tempo reale ----
+
+void print_replay_report(const ReplayStats *st, const ReplayOptions *opt,
+                         float dt) {
+    printf("\n========== REPLAY TEMPO REALE ==========\n");
+    printf("  Velocità: %.2fx, pacchetti da %d campioni, %d ripetizioni\n",
+           opt->speed, opt->packet, opt->repeat);
+    printf("  Budget per campione: %.0f ns, durata replay: %.2f s\n",
+           st->budget_ns, st->wall_s);
+    printf("  Campioni: %ld, scadenze mancate: %ld (%.4f%%)",
+           st->samples, st->misses,
+           st->samples > 0 ? 100.0 * st->misses / st->samples : 0.0);
+    if (st->misses > 0) printf(", ritardo max %.0f ns", st->late_max_ns);
+    printf("\n");
+    
+    printf("  %-28s", "Percentile");
+    for (int p = 0; p < REPLAY_NPCT; p++) {
+        if (replay_percentiles[p] >= 100.0) printf(" %10s", "max");
+        else printf(" %9gp", replay_percentiles[p]);
+    }
+    printf("\n  %-28s", "Elaborazione campione (ns)");
+    for (int p = 0; p < REPLAY_NPCT; p++) printf(" %10.0f", st->proc_ns[p]);
+    printf("\n");
+    
+    if (st->n_alarms == 0) {
+        printf("  Trigger: %d, nessun allarme: latenza non disponibile\n",
+               st->n_triggers);
+        return;
+    }
+    printf("  %-28s", "Trigger -> allarme (ms)");
+    for (int p = 0; p < REPLAY_NPCT; p++) printf(" %10.3f", st->latency_ms[p]);
+    printf("\n  %-28s", "Acquisizione -> allarme (us)");
+    for (int p = 0; p < REPLAY_NPCT; p++) printf(" %10.1f", st->reaction_us[p]);
+    printf("\n");
+    printf("  Ultima ripetizione: trigger t=%.3fs, allarme %.3f s dopo "
+           "(%d allarmi su %d ripetizioni)\n",
+           st->trigger_idx * dt, (st->alarm_idx - st->trigger_idx) * dt,
+           st->n_alarms, opt->repeat);
+}
+
+// ---- Streaming e acquisizione da rete ----
+
+void print_stream_event(const StreamEvent *ev, long trigger_idx, float dt) {
+    if (ev->type & STREAM_EVENT_TRIGGER) {
+        printf("✓ TRIGGER: indice=%ld, t=%.3fs, STA/LTA=%.2f "
+               "(elaborazione %.0f ns)\n",
+               ev->sample_idx, ev->sample_idx * dt, ev->ratio, ev->proc_ns);
+    }
+    if (ev->type & STREAM_EVENT_ALARM) {
+        printf("*** ALLARME ROSSO! *** indice=%ld, %.3f s dopo trigger, "
+               "P=%.2f%% (elaborazione %.0f ns)\n",
+               ev->sample_idx, (ev->sample_idx - trigger_idx) * dt,
+               ev->prob * 100.0f, ev->proc_ns);
+    }
+    if (ev->type & STREAM_EVENT_PTM_END) {
+        printf("  Fine finestra post-trigger: indice=%ld, P=%.2f%%\n",
+               ev->sample_idx, ev->prob * 100.0f);
+    }
+}
+
+void print_ingest_report(const IngestStats *st, long samples, float dt) {
+    printf("\n========== ACQUISIZIONE ==========\n");
+    printf("  Pacchetti: %ld (%.1f kB), campioni analizzati: %ld (%.1f s)\n",
+           st->packets, st->bytes / 1024.0, samples, samples * dt);
+    printf("  Buchi interpolati: %ld (%ld campioni)\n", st->gaps, st->gap_samples);
+    printf("  Fuori ordine: %ld, duplicati: %ld, in ritardo: %ld\n",
+           st->out_of_order, st->duplicates, st->late);
+    printf("  Rifiutati: %ld, oltre capacità: %ld\n", st->rejected, st->overflow);
+    if (st->lost > 0) {
+        printf("  Canali persi: %ld (%ld campioni mantenuti)\n", st->lost,
+               st->held_samples);
+    }
+}
@@ -2,15 +2,74 @@
 #define IO_H
 
 #include "types.h"
+#include "waveform.h"
+#include "drift_analysis.h"
+#include "trigger.h"
+#include "replay.h"
+#include "ingest.h"
+#include <pthread.h>
 
-// Leggi file accelerazioni
+// Leggi file accelerazioni (parsing parallelo a blocchi, come strtof);
+// su un valore non valido si ferma e ritorna i campioni letti
 int read_acceleration_file(const char *filename, float *data, 
                            int max_samples, float unit_conversion);
 
-// Scrivi risultati
-void write_results(const char *filename, SignalData *top, SignalData *base,
-                   float *drift, float *drift_norm, int n,
-                   float dt, int alarm_idx);
+// Carica un canale in data: testo (unità convertita in lettura) oppure
+// .dwsf mappato in wf (da chiudere con waveform_close). Ritorna i campioni
+int load_channel(const char *filename, int channel, SignalData *data,
+                 WaveformFile *wf, float unit_conv, int fs);
+
+// File d'ingresso letto una sola volta per la cache filtri: impronta del
+// contenuto subito, parsing solo se la cache non è valida
+typedef struct {
+    const char *filename;
+    char *text;               // Testo mappato o letto (NULL per i .dwsf)
+    size_t size;
+    int mapped;
+    uint64_t hash;            // Impronta FNV-1a del contenuto
+} ChannelSource;
+
+// Legge (testo) o mappa in wf (.dwsf) il file e ne calcola l'impronta
+int open_channel_source(ChannelSource *src, const char *filename,
+                        WaveformFile *wf);
+
+// Come load_channel, dal contenuto già letto da open_channel_source
+int load_channel_source(const ChannelSource *src, int channel, SignalData *data,
+                        WaveformFile *wf, float unit_conv, int fs);
+
+// Rilascia il testo (il .dwsf resta in wf)
+void close_channel_source(ChannelSource *src);
+
+// Formato del file risultati
+typedef enum {
+    RESULTS_CSV,              // Testo, una riga per campione
+    RESULTS_BINARY            // .dwsf a colonne (vedi write_results)
+} ResultsFormat;
+
+// Richiesta di scrittura risultati per le righe [start, end)
+typedef struct {
+    char filename[300];       // Nome input (256) più suffisso
+    ResultsFormat format;
+    const float *disp_top;
+    const float *disp_base;
+    float norm_height;        // Altezza per il drift normalizzato (m)
+    float dt;
+    int fs;
+    int start, end;
+    int alarm_idx;
+    pthread_t thread;         // Usati internamente
+    int running;
+    int ok;
+} ResultsWriter;
+
+// Scrivi risultati (buffer grandi, formattazione senza printf). Il binario
+// ha 5 canali: drift (m), drift norm. (mm/m), disp TOP, disp BASE, allarme;
+// start_time = tempo della prima riga dall'inizio registrazione.
+// Con async i dati devono restare validi fino a wait_results
+int write_results(ResultsWriter *w, int async);
+
+// Attende la scrittura asincrona, ritorna 1 se riuscita
+int wait_results(ResultsWriter *w);
 
 // Stampa statistiche input
 void print_input_statistics(int n_samples, float dt, 
@@ -19,4 +78,30 @@ void print_input_statistics(int n_samples, float dt,
 // Stampa report finale
 void print_final_report(AnalysisResults *results, AlarmThreshold *threshold);
 
+// Stampa la matrice di fragilità (una riga per soglia)
+void print_fragility_matrix(const FragilityMatrix *m, float dt);
+
+// Scrive la matrice di fragilità in CSV
+int write_fragility_csv(const char *filename, const FragilityMatrix *m,
+                        float dt);
+
+// Stampa pick e massimi di ogni rivelatore del banco
+void print_trigger_bank(const TriggerBankResult *r, const TriggerBankParams *bank,
+                        float dt);
+
+// Scrive le funzioni caratteristiche del banco (una riga per campione)
+int write_trigger_bank_csv(const char *filename, const TriggerBankResult *r,
+                           float dt);
+
+// Stampa scadenze mancate e percentili di tempo e latenza del replay
+void print_replay_report(const ReplayStats *st, const ReplayOptions *opt,
+                         float dt);
+
+// Riga a video per un evento del motore streaming (latenza dal trigger
+// trigger_idx dello StreamEngine)
+void print_stream_event(const StreamEvent *ev, long trigger_idx, float dt);
+
+// Stampa pacchetti ricevuti, buchi e anomalie d'ordine dell'acquisizione
+void print_ingest_report(const IngestStats *st, long samples, float dt);
+
 #endif
\ No newline at end of file
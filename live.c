@@ -0,0 +1,245 @@
+#include "live.h"
+#include "stream.h"
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static volatile sig_atomic_t monitor_stop = 0;
+
+static void on_monitor_sigint(int sig) {
+    (void)sig;
+    monitor_stop = 1;
+}
+
+uint64_t live_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// I nomi POSIX iniziano con '/'
+static void shm_name(char *out, size_t len, const char *name) {
+    if (!name || !*name) name = LIVE_DEFAULT_NAME;
+    snprintf(out, len, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+// Intestazione del profilo; la sequenza dispari segnala ai lettori che
+// il segmento sta cambiando (lo snapshot segue con live_publish)
+static void write_profile(LiveSegment *seg, const AlarmThreshold *threshold,
+                          float height) {
+    unsigned s = atomic_load_explicit(&seg->seq, memory_order_relaxed);
+    atomic_store_explicit(&seg->seq, s | 1u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    seg->building = threshold->type;
+    seg->damage = threshold->state;
+    seg->height = height;
+    seg->drift_limit = threshold->drift_limit;
+    seg->prob_threshold = threshold->prob_threshold;
+}
+
+int live_publisher_open(LivePublisher *pub, const char *name, int fs,
+                        const AlarmThreshold *threshold, float height) {
+    memset(pub, 0, sizeof(*pub));
+    shm_name(pub->name, sizeof(pub->name), name);
+
+    int fd = shm_open(pub->name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return 0;
+    if (ftruncate(fd, sizeof(LiveSegment)) != 0) {
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, sizeof(LiveSegment), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    pub->seg = (LiveSegment*)map;
+
+    // Un segmento riaperto continua la sequenza: i lettori già collegati
+    // non vedono mai tornare indietro il numero di sequenza
+    LiveSegment *seg = pub->seg;
+    memcpy(seg->magic, LIVE_MAGIC, 4);
+    seg->version = LIVE_VERSION;
+    seg->pid = (int32_t)getpid();
+    seg->fs = fs;
+    atomic_store_explicit(&seg->running, 1, memory_order_relaxed);
+    write_profile(seg, threshold, height);
+
+    pub->snap.trigger_idx = -1;
+    pub->snap.alarm_idx = -1;
+    pub->snap.sample_idx = -1;
+    pub->last_pgd = -1.0f;
+    live_publish(pub, &pub->snap);
+    return 1;
+}
+
+void live_publish(LivePublisher *pub, const LiveSnapshot *snap) {
+    LiveSegment *seg = pub->seg;
+    uint64_t w[LIVE_WORDS];
+    memcpy(w, snap, sizeof(w));
+
+    // Seqlock: sequenza dispari, dati, sequenza pari con release
+    unsigned s = atomic_load_explicit(&seg->seq, memory_order_relaxed);
+    s |= 1u;
+    atomic_store_explicit(&seg->seq, s, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t k = 0; k < LIVE_WORDS; k++) {
+        atomic_store_explicit(&seg->words[k], w[k], memory_order_relaxed);
+    }
+    atomic_store_explicit(&seg->seq, s + 1, memory_order_release);
+}
+
+void live_publisher_set_profile(LivePublisher *pub,
+                                const AlarmThreshold *threshold, float height) {
+    write_profile(pub->seg, threshold, height);
+    live_publish(pub, &pub->snap);
+}
+
+void live_publisher_close(LivePublisher *pub) {
+    if (!pub->seg) return;
+    atomic_store_explicit(&pub->seg->running, 0, memory_order_release);
+    munmap(pub->seg, sizeof(LiveSegment));
+    shm_unlink(pub->name);
+    pub->seg = NULL;
+}
+
+int live_reader_open(LiveReader *rd, const char *name) {
+    char path[64];
+    shm_name(path, sizeof(path), name);
+    rd->seg = NULL;
+
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(LiveSegment)) {
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, sizeof(LiveSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+
+    const LiveSegment *seg = (const LiveSegment*)map;
+    if (memcmp(seg->magic, LIVE_MAGIC, 4) != 0 || seg->version != LIVE_VERSION) {
+        munmap(map, sizeof(LiveSegment));
+        return 0;
+    }
+    rd->seg = seg;
+    return 1;
+}
+
+unsigned live_read(const LiveReader *rd, LiveSnapshot *snap) {
+    // Il segmento è mappato in sola lettura: i load atomici non scrivono
+    LiveSegment *seg = (LiveSegment*)rd->seg;
+    uint64_t w[LIVE_WORDS];
+
+    for (int attempt = 0; attempt < LIVE_READ_RETRIES; attempt++) {
+        unsigned s1 = atomic_load_explicit(&seg->seq, memory_order_acquire);
+        if (s1 & 1u) continue;
+        for (size_t k = 0; k < LIVE_WORDS; k++) {
+            w[k] = atomic_load_explicit(&seg->words[k], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        unsigned s2 = atomic_load_explicit(&seg->seq, memory_order_relaxed);
+        if (s1 == s2) {
+            if (s1 == 0) return 0;
+            memcpy(snap, w, sizeof(w));
+            return s1;
+        }
+    }
+    return 0;
+}
+
+int live_writer_running(const LiveReader *rd) {
+    LiveSegment *seg = (LiveSegment*)rd->seg;
+    return atomic_load_explicit(&seg->running, memory_order_acquire);
+}
+
+void live_reader_close(LiveReader *rd) {
+    if (rd->seg) munmap((void*)rd->seg, sizeof(LiveSegment));
+    rd->seg = NULL;
+}
+
+// ---- Monitor da riga di comando ----
+
+static const char *state_name(int state) {
+    switch (state) {
+        case STREAM_LISTENING: return "ascolto";
+        case STREAM_MONITORING: return "post-trigger";
+        default: return "attesa riarmo";
+    }
+}
+
+int run_live_monitor(const char *name) {
+    LiveReader rd;
+    if (!live_reader_open(&rd, name)) {
+        printf("❌ ERRORE: Segmento %s non trovato (scrittore non avviato?)\n",
+               name ? name : LIVE_DEFAULT_NAME);
+        return 1;
+    }
+    const LiveSegment *seg = rd.seg;
+    printf("Monitor di %s: pid %d, %d Hz, soglia P > %.0f%% (drift %.4f)\n",
+           name ? name : LIVE_DEFAULT_NAME, seg->pid, seg->fs,
+           seg->prob_threshold * 100.0f, seg->drift_limit);
+    fflush(stdout);
+
+    struct sigaction sa, old_sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_monitor_sigint;
+    sigaction(SIGINT, &sa, &old_sa);
+    monitor_stop = 0;
+
+    LiveSnapshot snap, prev;
+    memset(&prev, 0, sizeof(prev));
+    unsigned last_seq = 0;
+    uint64_t next_status = 0;
+    double worst_us = 0.0;
+    long alarms_seen = 0;
+    struct timespec pause = {0, LIVE_POLL_NS};
+
+    while (!monitor_stop && live_writer_running(&rd)) {
+        unsigned seq = live_read(&rd, &snap);
+        if (seq == 0 || seq == last_seq) {
+            nanosleep(&pause, NULL);
+            continue;
+        }
+        uint64_t now = live_now_ns();
+        last_seq = seq;
+        float dt = seg->fs > 0 ? 1.0f / seg->fs : 0.0f;
+
+        if (snap.n_triggers != prev.n_triggers) {
+            printf("✓ TRIGGER: indice=%lld, t=%.3fs, STA/LTA=%.2f "
+                   "(visto dopo %.1f µs)\n", (long long)snap.trigger_idx,
+                   snap.trigger_idx * dt, snap.sta_lta,
+                   (now - snap.update_ns) / 1e3);
+        }
+        if (snap.n_alarms != prev.n_alarms) {
+            double us = (now - snap.alarm_ns) / 1e3;
+            if (us > worst_us) worst_us = us;
+            alarms_seen++;
+            printf("*** ALLARME ROSSO! *** indice=%lld, P=%.2f%%, PGD=%.5f m "
+                   "(visto dopo %.1f µs)\n", (long long)snap.alarm_idx,
+                   snap.prob * 100.0f, snap.pgd_base, us);
+        }
+        if (now >= next_status) {
+            printf("  [%s] campione %lld, STA/LTA %.2f, PGD %.5f m, "
+                   "drift %.2f mm/m, P %.2f%%%s\n", state_name(snap.state),
+                   (long long)snap.sample_idx, snap.sta_lta, snap.pgd_base,
+                   snap.max_drift_norm * 1000.0f, snap.prob * 100.0f,
+                   snap.alarm ? ", ALLARME" : "");
+            next_status = now + 1000000000ull;
+        }
+        fflush(stdout);
+        prev = snap;
+    }
+
+    printf("Monitor terminato%s: %ld allarmi, propagazione massima %.1f µs\n",
+           monitor_stop ? "" : " (scrittore chiuso)", alarms_seen, worst_us);
+    sigaction(SIGINT, &old_sa, NULL);
+    live_reader_close(&rd);
+    return 0;
+}
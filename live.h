@@ -0,0 +1,103 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "types.h"
+
+// Stato live in memoria condivisa POSIX (shm_open), per i controllori
+// dell'edificio: un solo scrittore (il motore streaming) aggiorna a ogni
+// campione uno snapshot protetto da seqlock, i lettori lo copiano senza
+// lock e riprovano se lo scrittore era a metà aggiornamento
+#define LIVE_MAGIC "DWSL"
+#define LIVE_VERSION 1
+#define LIVE_DEFAULT_NAME "/dosews"
+#define LIVE_READ_RETRIES 1000     // Tentativi prima di rinunciare a una lettura
+#define LIVE_POLL_NS 20000         // Attesa tra due letture di --monitor
+
+// Snapshot pubblicato (multiplo di 8 byte, copiato a parole da 64 bit)
+typedef struct {
+    int64_t sample_idx;       // Ultimo campione elaborato
+    int64_t trigger_idx;      // Trigger dell'evento corrente (-1 = nessuno)
+    int64_t alarm_idx;        // Allarme dell'evento corrente (-1 = nessuno)
+    uint64_t update_ns;       // CLOCK_MONOTONIC della pubblicazione
+    uint64_t alarm_ns;        // CLOCK_MONOTONIC dell'ultimo allarme
+    float sta_lta;            // Rapporto STA/LTA corrente
+    float pgd_base;           // PGD base dell'evento corrente (m)
+    float max_drift_abs;      // Drift assoluto max (m)
+    float max_drift_norm;     // Drift normalizzato max (adimensionale)
+    float prob;               // Probabilità di superamento corrente
+    int32_t state;            // StreamState
+    int32_t alarm;            // Allarme attivo nell'evento corrente
+    int32_t n_triggers;       // Trigger dall'avvio
+    int32_t n_alarms;         // Allarmi dall'avvio
+    int32_t reserved;
+} LiveSnapshot;
+
+#define LIVE_WORDS (sizeof(LiveSnapshot) / sizeof(uint64_t))
+
+// Segmento condiviso: intestazione fissa, poi sequenza e snapshot su
+// linee di cache separate
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    int32_t pid;              // Processo scrittore
+    int32_t fs;
+    int32_t building;         // BuildingType
+    int32_t damage;           // DamageState
+    float height;
+    float drift_limit;
+    float prob_threshold;
+    atomic_int running;       // 0 quando lo scrittore ha chiuso
+    _Alignas(64) atomic_uint seq;   // Dispari durante l'aggiornamento
+    _Alignas(64) _Atomic uint64_t words[LIVE_WORDS];
+} LiveSegment;
+
+// Lato scrittore
+typedef struct {
+    LiveSegment *seg;
+    char name[64];
+    LiveSnapshot snap;        // Copia di lavoro aggiornata dal motore
+    float last_pgd;           // PGD per cui snap.prob è già calcolata
+} LivePublisher;
+
+// Lato lettore (libreria per i controllori)
+typedef struct {
+    const LiveSegment *seg;
+} LiveReader;
+
+// Crea (o riapre) il segmento name e scrive l'intestazione
+int live_publisher_open(LivePublisher *pub, const char *name, int fs,
+                        const AlarmThreshold *threshold, float height);
+
+// Pubblica uno snapshot (senza attese né chiamate di sistema)
+void live_publish(LivePublisher *pub, const LiveSnapshot *snap);
+
+// Aggiorna edificio e soglie nell'intestazione (ricarica del demone)
+void live_publisher_set_profile(LivePublisher *pub,
+                                const AlarmThreshold *threshold, float height);
+
+// Segna il segmento come chiuso e lo rimuove
+void live_publisher_close(LivePublisher *pub);
+
+// Mappa in sola lettura un segmento esistente
+int live_reader_open(LiveReader *rd, const char *name);
+
+// Copia uno snapshot coerente; ritorna il numero di sequenza (pari, > 0)
+// oppure 0 se lo scrittore non ha ancora pubblicato o non si stabilizza
+unsigned live_read(const LiveReader *rd, LiveSnapshot *snap);
+
+// Vero finché lo scrittore è attivo
+int live_writer_running(const LiveReader *rd);
+
+// Rilascia la mappatura
+void live_reader_close(LiveReader *rd);
+
+// Nanosecondi CLOCK_MONOTONIC (stesso orologio di update_ns/alarm_ns)
+uint64_t live_now_ns(void);
+
+// dosews --monitor [nome]: stampa trigger e allarmi con la latenza di
+// propagazione e uno stato al secondo, fino alla chiusura dello scrittore
+int run_live_monitor(const char *name);
+
+#endif
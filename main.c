@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "config.h"
 #include "types.h"
 #include "filters.h"
@@ -7,16 +8,29 @@
 #include "trigger.h"
 #include "drift_analysis.h"
 #include "io.h"
+#include "stream.h"
+#include "waveform.h"
+#include "batch.h"
+#include "pipeline.h"
+#include "multichannel.h"
+#include "scan.h"
+#include "replay.h"
+#include "ingest.h"
+#include "live.h"
+#include "daemon.h"
+#include "decimate.h"
+#include "filter_cache.h"
 
 // Definizioni costanti
 const float BUILDING_HEIGHT_M = 10.0f;
 const int INPUT_UNIT_IS_G = 1;
 const float G_TO_MS2 = 9.81f;
-const float REG_INTERCEPT = -1.01f;
-const float REG_SLOPE = 0.59f;
-const float PRED_STD_DEV_LOG10 = 0.25f;
+int verbosity = 1;
+float REG_INTERCEPT = -1.01f;
+float REG_SLOPE = 0.59f;
+float PRED_STD_DEV_LOG10 = 0.25f;
 
-const AlarmThreshold thresholds[] = {
+AlarmThreshold thresholds[] = {
     {RC_LOW_RISE, MODERATE,  0.0184f, 20.86f},
     {RC_LOW_RISE, EXTENSIVE, 0.0301f, 15.53f},
     {RC_LOW_RISE, COMPLETE,  0.0451f, 16.52f},
@@ -54,6 +68,14 @@ const char* damage_names[] = {
     "Complete (collasso completo)"
 };
 
+// Nomi brevi (manifest batch, matrice di fragilità)
+const char *building_keys[] = {
+    "RC_LOW_RISE", "RC_MID_RISE", "URM_REG_LOW_RISE",
+    "URM_REG_MID_RISE", "URM_SS_LOW_RISE", "URM_SS_MID_RISE"
+};
+
+const char *damage_keys[] = {"MODERATE", "EXTENSIVE", "COMPLETE"};
+
 // Funzioni per menu interattivo
 void print_building_types() {
     printf("\n========== TIPOLOGIE EDIFICIO ==========\n");
@@ -206,15 +228,546 @@ void print_configuration_summary(BuildingType building_type, DamageState damage_
     printf("==========================================================\n\n");
 }
 
-int main() {
+// Segmento live per il motore streaming; NULL (con avviso) se non disponibile
+static LivePublisher *open_live_state(LivePublisher *pub, const char *name,
+                                      int fs, const AlarmThreshold *threshold,
+                                      float building_height) {
+    if (!name) return NULL;
+    if (!live_publisher_open(pub, name, fs, threshold, building_height)) {
+        printf("⚠ Stato live non disponibile (%s): si prosegue senza\n", name);
+        return NULL;
+    }
+    printf("✓ Stato live pubblicato in %s (dosews --monitor %s)\n",
+           pub->name, pub->name);
+    return pub;
+}
+
+// Sostituisce i due canali con la versione decimata (acc già in m/s²)
+static int decimate_channels(const Decimator *dec, SignalData **top,
+                             SignalData **base, int *n) {
+    int n_out = decimated_length(dec, *n);
+    SignalData *dec_top = create_signal_data(n_out);
+    SignalData *dec_base = create_signal_data(n_out);
+    if (!dec_top || !dec_base) {
+        if (dec_top) free_signal_data(dec_top);
+        if (dec_base) free_signal_data(dec_base);
+        return 0;
+    }
+    
+    if (!decimate_signal(dec, (*top)->acc, *n, (*top)->acc_scale, dec_top->acc) ||
+        !decimate_signal(dec, (*base)->acc, *n, (*base)->acc_scale, dec_base->acc)) {
+        free_signal_data(dec_top);
+        free_signal_data(dec_base);
+        return 0;
+    }
+    
+    free_signal_data(*top);
+    free_signal_data(*base);
+    *top = dec_top;
+    *base = dec_base;
+    *n = n_out;
+    return 1;
+}
+
+// Elaborazione streaming: pacchetti da 100 ms come da digitalizzatore
+static void run_stream_mode(SignalData *top, SignalData *base, int n,
+                            FilterConfig *filter, float sta_s, float lta_s,
+                            float ptm_s, float building_height,
+                            AlarmThreshold *alarm_threshold,
+                            LivePublisher *live) {
+    TriggerParams trigger;
+    init_trigger_params(&trigger, sta_s, lta_s);
+
+    StreamEngine eng;
+    if (!stream_init(&eng, filter, &trigger, alarm_threshold,
+                     ptm_s, building_height)) {
+        printf("❌ ERRORE: Impossibile allocare il motore streaming\n");
+        return;
+    }
+    stream_set_input_scale(&eng, top->acc_scale, base->acc_scale);
+    if (live) stream_set_live(&eng, live);
+
+    printf("\n========== ELABORAZIONE STREAMING ==========\n");
+    printf("Parametri: STA=%.1fs, LTA=%.1fs, Soglia=%.1f, PTM=%.1fs\n",
+           sta_s, lta_s, trigger.threshold, ptm_s);
+
+    int packet = filter->fs / 10 > 0 ? filter->fs / 10 : 1;
+    StreamEvent events[8];
+    AnalysisResults last = eng.results;
+    int n_events_total = 0;
+
+    for (int i = 0; i < n; i += packet) {
+        int count = (n - i < packet) ? n - i : packet;
+        int n_ev = stream_push_packet(&eng, top->acc + i, base->acc + i,
+                                      count, events, 8);
+        for (int e = 0; e < n_ev; e++) {
+            StreamEvent *ev = &events[e];
+            n_events_total++;
+            print_stream_event(ev, eng.trigger_idx, filter->dt);
+            if (ev->type & (STREAM_EVENT_ALARM | STREAM_EVENT_PTM_END)) {
+                last = eng.results;
+            }
+        }
+    }
+
+    if (eng.state == STREAM_MONITORING) last = eng.results;
+
+    if (n_events_total == 0) {
+        printf("✗ NESSUN TRIGGER\n");
+    } else {
+        print_final_report(&last, alarm_threshold);
+    }
+
+    printf("\n========== LATENZA STREAMING ==========\n");
+    printf("  Campioni elaborati: %ld\n", eng.stats.samples);
+    printf("  Tempo medio per campione: %.0f ns\n",
+           eng.stats.total_ns / (eng.stats.samples > 0 ? eng.stats.samples : 1));
+    printf("  Tempo massimo per campione: %.0f ns\n", eng.stats.max_ns);
+    printf("  Budget per campione (1/fs): %.0f ns\n", filter->dt * 1e9);
+
+    stream_free(&eng);
+}
+
+// Replay del record al ritmo di acquisizione (o N volte più veloce) nel
+// motore streaming: scadenze per campione e latenza trigger -> allarme
+static void run_replay_mode(SignalData *top, SignalData *base, int n,
+                            FilterConfig *filter, float sta_s, float lta_s,
+                            float ptm_s, float building_height,
+                            AlarmThreshold *alarm_threshold,
+                            const ReplayOptions *opt) {
+    printf("\n========== REPLAY ==========\n");
+    printf("Parametri: STA=%.1fs, LTA=%.1fs, Soglia=%.1f, PTM=%.1fs\n",
+           sta_s, lta_s, STA_LTA_THRESHOLD, ptm_s);
+    printf("Durata prevista: %.1f s (%d x %.1f s a %.2fx)\n",
+           opt->repeat * n * filter->dt / opt->speed, opt->repeat,
+           n * filter->dt, opt->speed);
+    fflush(stdout);
+    
+    ReplayStats stats;
+    if (!run_replay(top->acc, base->acc, n, top->acc_scale, base->acc_scale,
+                    filter, sta_s, lta_s, ptm_s, building_height,
+                    alarm_threshold, opt, &stats)) {
+        printf("❌ ERRORE: Impossibile allocare il motore streaming\n");
+        return;
+    }
+    
+    if (stats.trigger_idx < 0) {
+        printf("✗ NESSUN TRIGGER\n");
+    } else {
+        print_final_report(&stats.results, alarm_threshold);
+    }
+    print_replay_report(&stats, opt, filter->dt);
+}
+
+// dosews --convert out.dwsf fs g|ms2 [--start t] in1.txt [in2.txt ...]
+static int run_convert(int argc, char *argv[]) {
+    if (argc < 6) {
+        printf("Uso: %s --convert out.dwsf fs g|ms2 [--start t_epoch] "
+               "in1.txt [in2.txt ...]\n", argv[0]);
+        return 1;
+    }
+    
+    int fs = atoi(argv[3]);
+    int unit = (strcmp(argv[4], "g") == 0) ? WAVEFORM_UNIT_G : WAVEFORM_UNIT_MS2;
+    double start_time = 0.0;
+    int first_in = 5;
+    
+    if (strcmp(argv[5], "--start") == 0 && argc >= 8) {
+        start_time = atof(argv[6]);
+        first_in = 7;
+    }
+    
+    int ok = waveform_convert_text(argv[2], fs, unit, start_time,
+                                   (const char *const*)(argv + first_in),
+                                   argc - first_in);
+    return ok ? 0 : 1;
+}
+
+// Stato del server di acquisizione condiviso con la callback degli eventi
+typedef struct {
+    float dt;
+    AnalysisResults last;
+    int n_events;
+} ServeContext;
+
+static void on_ingest_event(const StreamEvent *ev, const StreamEngine *eng,
+                            void *ctx) {
+    ServeContext *sc = (ServeContext*)ctx;
+    sc->n_events++;
+    print_stream_event(ev, eng->trigger_idx, sc->dt);
+    if (ev->type & (STREAM_EVENT_ALARM | STREAM_EVENT_PTM_END)) {
+        sc->last = eng->results;
+    }
+    fflush(stdout);
+}
+
+// dosews --serve udp|tcp porta edificio danno altezza fs [stazione]
+static int run_serve(int argc, char *argv[]) {
+    if (argc < 8) {
+        printf("Uso: %s --serve udp|tcp porta edificio danno altezza fs "
+               "[stazione] [--live nome]\n", argv[0]);
+        return 1;
+    }
+    IngestProto proto = (strcmp(argv[2], "tcp") == 0) ? INGEST_TCP : INGEST_UDP;
+    int port = atoi(argv[3]);
+    int type = parse_table_key(argv[4], building_keys, 6);
+    int state = parse_table_key(argv[5], damage_keys, 3);
+    float building_height = (float)atof(argv[6]);
+    int fs = atoi(argv[7]);
+    int station = 0;
+    const char *live_name = NULL;
+    for (int i = 8; i < argc; i++) {
+        if (strcmp(argv[i], "--live") == 0 && i + 1 < argc) live_name = argv[++i];
+        else station = atoi(argv[i]);
+    }
+    
+    AlarmThreshold threshold = {(BuildingType)type, (DamageState)state, 0.0f, 0.0f};
+    if (type < 0 || state < 0 || building_height <= 0.0f ||
+        !get_alarm_thresholds(threshold.type, threshold.state,
+                              &threshold.drift_limit, &threshold.prob_threshold)) {
+        printf("❌ ERRORE: Edificio, danno o altezza non validi\n");
+        return 1;
+    }
+    
+    FilterConfig filter;
+    init_filter_config(&filter, fs);
+    if (filter.hp_a == 0.0f) {
+        printf("❌ ERRORE: Frequenza non supportata (%d Hz)\n", fs);
+        return 1;
+    }
+    
+    TriggerParams trigger;
+    init_trigger_params(&trigger, STA_WINDOW_S, LTA_WINDOW_S);
+    StreamEngine eng;
+    IngestBuffer ib;
+    if (!stream_init(&eng, &filter, &trigger, &threshold, PTM_WINDOW_S,
+                     building_height)) {
+        printf("❌ ERRORE: Impossibile allocare il motore streaming\n");
+        cleanup_filter_config(&filter);
+        return 1;
+    }
+    if (!ingest_init(&ib, station, fs)) {
+        printf("❌ ERRORE: Impossibile allocare i buffer di acquisizione\n");
+        stream_free(&eng);
+        cleanup_filter_config(&filter);
+        return 1;
+    }
+    
+    LivePublisher live_pub;
+    LivePublisher *live = open_live_state(&live_pub, live_name, fs, &threshold,
+                                          building_height);
+    if (live) stream_set_live(&eng, live);
+    
+    printf("\n========== ACQUISIZIONE DA RETE ==========\n");
+    printf("Edificio: %s, danno: %s, altezza %.1f m\n",
+           building_keys[type], damage_keys[state], building_height);
+    printf("Parametri: STA=%.1fs, LTA=%.1fs, Soglia=%.1f, PTM=%.1fs\n",
+           STA_WINDOW_S, LTA_WINDOW_S, trigger.threshold, PTM_WINDOW_S);
+    
+    ServeContext sc = {filter.dt, eng.results, 0};
+    int ok = run_ingest_server(proto, port, &ib, &eng, on_ingest_event, NULL,
+                               &sc);
+    if (ok) {
+        if (eng.state == STREAM_MONITORING) sc.last = eng.results;
+        if (sc.n_events == 0) {
+            printf("✗ NESSUN TRIGGER\n");
+        } else {
+            print_final_report(&sc.last, &threshold);
+        }
+        print_ingest_report(&ib.stats, eng.stats.samples, filter.dt);
+        printf("  Tempo medio per campione: %.0f ns (massimo %.0f ns)\n",
+               eng.stats.total_ns / (eng.stats.samples > 0 ? eng.stats.samples : 1),
+               eng.stats.max_ns);
+    }
+    
+    if (live) live_publisher_close(live);
+    ingest_free(&ib);
+    stream_free(&eng);
+    cleanup_filter_config(&filter);
+    return ok ? 0 : 1;
+}
+
+// dosews --send udp|tcp host:porta fs g|ms2 file_top file_base [opzioni]
+static int run_send(int argc, char *argv[]) {
+    if (argc < 8 || !strchr(argv[3], ':')) {
+        printf("Uso: %s --send udp|tcp host:porta fs g|ms2 file_top file_base\n"
+               "       [--speed X] [--packet N] [--i32] [--station S]\n"
+               "       [--drop N] [--reorder N]\n", argv[0]);
+        return 1;
+    }
+    IngestProto proto = (strcmp(argv[2], "tcp") == 0) ? INGEST_TCP : INGEST_UDP;
+    char host[256];
+    snprintf(host, sizeof(host), "%s", argv[3]);
+    char *colon = strrchr(host, ':');
+    *colon = '\0';
+    int port = atoi(colon + 1);
+    int fs = atoi(argv[4]);
+    float unit_conv = (strcmp(argv[5], "g") == 0) ? G_TO_MS2 : 1.0f;
+    
+    IngestSendOptions opt = {1.0, fs / 10 > 0 ? fs / 10 : 1, INGEST_FMT_F32, 0, 0, 0};
+    for (int i = 8; i < argc; i++) {
+        if (strcmp(argv[i], "--i32") == 0) opt.format = INGEST_FMT_I32;
+        else if (i + 1 >= argc) break;
+        else if (strcmp(argv[i], "--speed") == 0) opt.speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--packet") == 0) opt.packet = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--station") == 0) opt.station = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--drop") == 0) opt.drop_every = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--reorder") == 0) opt.reorder_every = atoi(argv[++i]);
+    }
+    
+    // Canali come in modalità interattiva: testo convertito, .dwsf mappato
+    WaveformFile wf_top = {0}, wf_base = {0};
+    SignalData *top = create_signal_data(0);
+    SignalData *base = create_signal_data(0);
+    int base_channel = (strcmp(argv[6], argv[7]) == 0) ? 1 : 0;
+    int n_top = top ? load_channel(argv[6], 0, top, &wf_top, unit_conv, fs) : -1;
+    int n_base = base ? load_channel(argv[7], base_channel, base, &wf_base,
+                                     unit_conv, fs) : -1;
+    
+    int ok = 0;
+    if (n_top < 0 || n_base < 0) {
+        printf("❌ Impossibile leggere i file TOP/BASE\n");
+    } else {
+        int n = (n_top < n_base) ? n_top : n_base;
+        printf("Invio %d campioni a %s:%d (%s, %.2fx)\n", n, host, port,
+               proto == INGEST_TCP ? "TCP" : "UDP", opt.speed);
+        ok = run_ingest_sender(proto, host, port, top->acc, base->acc, n,
+                               top->acc_scale, base->acc_scale, fs, &opt);
+    }
+    
+    free_signal_data(top);
+    free_signal_data(base);
+    waveform_close(&wf_top);
+    waveform_close(&wf_base);
+    return ok ? 0 : 1;
+}
+
+// Banco rivelatori su acc_fir TOP: riepilogo a video e CSV delle funzioni
+// caratteristiche; thresholds NULL = soglie predefinite
+static void report_trigger_bank(float *acc_fir, int n, FilterConfig *filter,
+                                const TriggerParams *trigger,
+                                const float *thresholds, const char *filein_top) {
+    // Tutti i rivelatori sullo stesso acc_fir, un solo passaggio
+    TriggerBankParams bank;
+    TriggerBankResult bank_result;
+    init_trigger_bank_params(&bank, trigger);
+    if (thresholds) {
+        for (int d = 0; d < DETECTOR_COUNT; d++) {
+            bank.threshold[d] = thresholds[d];
+        }
+    }
+    if (!run_trigger_bank(acc_fir, n, filter, &bank, &bank_result, 1)) {
+        printf("⚠ Banco rivelatori: record troppo corto o memoria insufficiente\n");
+        return;
+    }
+    
+    print_trigger_bank(&bank_result, &bank, filter->dt);
+    char fileout_bank[300];
+    snprintf(fileout_bank, sizeof(fileout_bank), "%s_triggers.csv", filein_top);
+    if (write_trigger_bank_csv(fileout_bank, &bank_result, filter->dt)) {
+        printf("✓ Funzioni caratteristiche: %s\n", fileout_bank);
+    } else {
+        printf("❌ ERRORE: Scrittura fallita su %s\n", fileout_bank);
+    }
+    free_trigger_bank(&bank_result);
+}
+
+int main(int argc, char *argv[]) {
     char filein_top[256], filein_base[256];
-    char fileout_csv[256], fileout_debug[256];
+    char fileout_debug[300];
+    WaveformFile wf_top = {0}, wf_base = {0};
     
     printf("==========================================================\n");
     printf("  DOSEWS - Sistema di Allerta Sismica per Edifici\n");
     printf("  Damage-based On-Site Early Warning System\n");
     printf("==========================================================\n\n");
     
+    if (argc > 1 && strcmp(argv[1], "--convert") == 0) {
+        return run_convert(argc, argv);
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        return run_serve(argc, argv);
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--send") == 0) {
+        return run_send(argc, argv);
+    }
+    
+    if (argc > 2 && strcmp(argv[1], "--daemon") == 0) {
+        return run_daemon(argv[2]);
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--monitor") == 0) {
+        return run_live_monitor(argc > 2 ? argv[2] : NULL);
+    }
+    
+    // dosews --batch manifest.txt [riepilogo.csv] [--iir] [--hugepages] [--bank]
+    if (argc > 2 && strcmp(argv[1], "--batch") == 0) {
+        const char *summary = NULL;
+        FirMode mode = FIR_MODE_EXACT;
+        TriggerBankParams batch_bank;
+        TriggerParams batch_trigger;
+        init_trigger_params(&batch_trigger, STA_WINDOW_S, LTA_WINDOW_S);
+        init_trigger_bank_params(&batch_bank, &batch_trigger);
+        int use_bank = 0;
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "--iir") == 0) mode = FIR_MODE_RECURSIVE;
+            else if (strcmp(argv[i], "--hugepages") == 0) set_signal_huge_pages(1);
+            else if (strcmp(argv[i], "--bank") == 0) use_bank = 1;
+            else if (strcmp(argv[i], "--serial-scan") == 0) set_parallel_scan(0);
+            else summary = argv[i];
+        }
+        verbosity = 0;
+        return run_batch(argv[2], summary, mode,
+                         use_bank ? &batch_bank : NULL) ? 0 : 1;
+    }
+    
+    // dosews --multi rete.dwsf edificio danno quota1,quota2,... [riepilogo.csv]
+    if (argc > 5 && strcmp(argv[1], "--multi") == 0) {
+        int type = parse_table_key(argv[3], building_keys, 6);
+        int state = parse_table_key(argv[4], damage_keys, 3);
+        float elevations[MC_MAX_FLOORS];
+        int n_elev = 0;
+        for (char *tok = strtok(argv[5], ","); tok && n_elev < MC_MAX_FLOORS;
+             tok = strtok(NULL, ",")) {
+            elevations[n_elev++] = (float)atof(tok);
+        }
+        if (type < 0 || state < 0) {
+            printf("❌ ERRORE: edificio o stato di danno non valido\n");
+            return 1;
+        }
+        const char *summary = (argc > 6) ? argv[6] : NULL;
+        return run_multichannel(argv[2], (BuildingType)type, (DamageState)state,
+                                elevations, n_elev, summary) ? 0 : 1;
+    }
+    
+    // Opzioni da riga di comando
+    int stream_mode = 0;
+    ReplayOptions replay = {0.0, 1, 1, NULL};
+    const char *live_name = NULL;
+    int recursive_fir = 0;
+    int results_binary = 0;
+    int results_window = 0;
+    int write_csv = 1;
+    int fused = 0;
+    int fragility = 0;
+    int trigger_bank = 0;
+    int decimate_fs = 0;
+    int use_cache = 0;
+    int have_bank_thresholds = 0;
+    float bank_thresholds[DETECTOR_COUNT];
+    TraceOptions trace_opt = {NULL, 1, 0};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stream") == 0) {
+            stream_mode = 1;
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc &&
+                   atof(argv[i+1]) > 0.0) {
+            replay.speed = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--replay-packet") == 0 && i + 1 < argc &&
+                   atoi(argv[i+1]) > 0) {
+            replay.packet = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--replay-repeat") == 0 && i + 1 < argc &&
+                   atoi(argv[i+1]) > 0) {
+            replay.repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--live") == 0 && i + 1 < argc) {
+            live_name = argv[++i];
+        } else if (strcmp(argv[i], "--iir") == 0) {
+            recursive_fir = 1;
+        } else if (strcmp(argv[i], "--bin-results") == 0) {
+            results_binary = 1;
+        } else if (strcmp(argv[i], "--window-results") == 0) {
+            results_window = 1;
+        } else if (strcmp(argv[i], "--no-results") == 0) {
+            write_csv = 0;
+        } else if (strcmp(argv[i], "--fused") == 0) {
+            fused = 1;
+        } else if (strcmp(argv[i], "--hugepages") == 0) {
+            set_signal_huge_pages(1);
+        } else if (strcmp(argv[i], "--serial-scan") == 0) {
+            set_parallel_scan(0);
+        } else if (strcmp(argv[i], "--matrix") == 0) {
+            fragility = 1;
+        } else if (strcmp(argv[i], "--trigger-bank") == 0) {
+            trigger_bank = 1;
+        } else if (strcmp(argv[i], "--bank-thresholds") == 0 && i + 1 < argc &&
+                   sscanf(argv[i+1], "%f,%f,%f,%f", &bank_thresholds[0],
+                          &bank_thresholds[1], &bank_thresholds[2],
+                          &bank_thresholds[3]) == DETECTOR_COUNT) {
+            trigger_bank = 1;
+            have_bank_thresholds = 1;
+            i++;
+        } else if (strcmp(argv[i], "--decimate") == 0 && i + 1 < argc &&
+                   atoi(argv[i+1]) > 0) {
+            decimate_fs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            use_cache = 1;
+        } else if (strcmp(argv[i], "--trace-every") == 0 && i + 1 < argc) {
+            trace_opt.decimation = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--trace-async") == 0) {
+            trace_opt.background = 1;
+        } else {
+            printf("Uso: %s [--stream] [--replay X [--replay-packet N] [--replay-repeat R]]\n"
+                   "       [--live nome]\n"
+                   "       [--iir] [--bin-results] [--window-results]\n"
+                   "       [--trace-every N] [--trace-async] [--fused] [--no-results]\n"
+                   "       [--hugepages] [--serial-scan] [--matrix] [--trigger-bank]\n"
+                   "       [--bank-thresholds sta_lta,ricorsivo,z,kurtosis]"
+                   " [--decimate fs]\n"
+                   "       [--cache]\n",
+                   argv[0]);
+            printf("     %s --convert out.dwsf fs g|ms2 [--start t] in.txt ...\n", argv[0]);
+            printf("     %s --batch manifest.txt [riepilogo.csv] [--iir] [--hugepages]\n"
+                   "       [--serial-scan] [--bank]\n", argv[0]);
+            printf("     %s --multi rete.dwsf edificio danno quota1,quota2,... "
+                   "[riepilogo.csv]\n", argv[0]);
+            printf("     %s --serve udp|tcp porta edificio danno altezza fs [stazione]\n"
+                   "       [--live nome]\n", argv[0]);
+            printf("     %s --send udp|tcp host:porta fs g|ms2 file_top file_base\n"
+                   "       [--speed X] [--packet N] [--i32] [--station S]"
+                   " [--drop N] [--reorder N]\n", argv[0]);
+            printf("     %s --monitor [nome]\n", argv[0]);
+            printf("     %s --daemon file.conf   (SIGHUP ricarica soglie e profili)\n",
+                   argv[0]);
+            printf("  --stream  elaborazione campione per campione (tempo reale)\n");
+            printf("  --replay X  campioni nel motore streaming a X volte il tempo\n");
+            printf("              reale: scadenze mancate e latenza trigger -> allarme\n");
+            printf("  --replay-packet N  campioni consegnati insieme (default 1)\n");
+            printf("  --replay-repeat R  ripetizioni del record per i percentili\n");
+            printf("  --live nome       stato live (trigger, PGD, drift, allarme) in\n");
+            printf("                    memoria condivisa a ogni campione, per --monitor\n");
+            printf("  --iir     passa-basso gaussiano ricorsivo al posto del FIR\n");
+            printf("  --bin-results     risultati in .dwsf a colonne invece del CSV\n");
+            printf("  --window-results  solo la finestra post-trigger nei risultati\n");
+            printf("  --trace-every N   un record di debug ogni N campioni\n");
+            printf("  --trace-async     log di debug formattato in background\n");
+            printf("  --fused           pipeline a blocchi in un solo passaggio\n");
+            printf("  --no-results      nessun file risultati (niente array intermedi)\n");
+            printf("  --hugepages       array del segnale su huge page (2 MB)\n");
+            printf("  --serial-scan     HP sempre seriale anche sui record lunghi\n");
+            printf("  --matrix          tutte le soglie edificio/danno in un passaggio\n");
+            printf("  --trigger-bank    STA/LTA classico e ricorsivo, Z e kurtosis\n");
+            printf("                    in un passaggio su acc_fir TOP\n");
+            printf("  --decimate fs     decimazione polifase a fs (divisore intero\n");
+            printf("                    della frequenza di ingresso, >= %d Hz) prima\n",
+                   DECIM_MIN_FS);
+            printf("                    della pipeline; drift entro %.0f%% del calcolo\n",
+                   DECIM_DRIFT_TOL * 100.0f);
+            printf("                    a piena frequenza\n");
+            printf("  --cache           riusa i segnali filtrati da %s/ (o da\n",
+                   FILTER_CACHE_DEFAULT_DIR);
+            printf("                    $%s), chiave sul contenuto dei file\n",
+                   FILTER_CACHE_ENV);
+            printf("  File .dwsf: formato binario mappato in memoria; per BASE\n");
+            printf("  lo stesso file di TOP usa il secondo canale\n");
+            printf("  Manifest batch: una riga per record\n");
+            printf("    edificio danno altezza fs g|ms2 file_top file_base\n");
+            printf("  Rete multi-piano: canali piano per piano dalla fondazione,\n");
+            printf("  1-3 componenti (X, Y, Z) per piano; quote dei piani sulla base\n");
+            return 1;
+        }
+    }
+    
     // CONFIGURAZIONE INTERATTIVA
     printf("Inizia la configurazione del sistema...\n");
     
@@ -225,9 +778,9 @@ int main() {
     int fs = get_sampling_frequency();
     
     // Parametri fissi (possono essere resi configurabili se necessario)
-    float sta_s = 0.5f;   // Short Term Average window
-    float lta_s = 6.0f;   // Long Term Average window
-    float ptm_s = 10.0f;  // Post-Trigger Monitoring window
+    float sta_s = STA_WINDOW_S;   // Short Term Average window
+    float lta_s = LTA_WINDOW_S;   // Long Term Average window
+    float ptm_s = PTM_WINDOW_S;   // Post-Trigger Monitoring window
     
     // Trova soglie per la configurazione scelta
     float drift_limit, prob_threshold;
@@ -245,18 +798,29 @@ int main() {
     getchar(); // Consuma il newline lasciato da scanf
     getchar(); // Aspetta INVIO
     
+    // Con la decimazione i filtri a valle (HP, FIR, STA/LTA) usano fs decimata
+    Decimator decimator = {0};
+    if (decimate_fs && !init_decimator(&decimator, fs, decimate_fs)) {
+        printf("❌ ERRORE: Decimazione non applicabile a %d Hz\n", fs);
+        return 1;
+    }
+    int fs_proc = decimate_fs ? decimate_fs : fs;
+    
     // Inizializza filtri
     FilterConfig filter;
-    init_filter_config(&filter, fs);
+    init_filter_config(&filter, fs_proc);
     
     if (filter.hp_a == 0.0f) {
-        printf("❌ ERRORE: Frequenza non supportata (%d Hz)\n", fs);
+        printf("❌ ERRORE: Frequenza non supportata (%d Hz)\n", fs_proc);
+        cleanup_decimator(&decimator);
         return 1;
     }
     
-    // Alloca dati
-    SignalData *top = create_signal_data(MAX_SAMPLES);
-    SignalData *base = create_signal_data(MAX_SAMPLES);
+    if (recursive_fir) set_fir_mode(&filter, FIR_MODE_RECURSIVE);
+    
+    // Alloca dati: arena vuota, dimensionata in lettura sul record
+    SignalData *top = create_signal_data(0);
+    SignalData *base = create_signal_data(0);
     
     if (!top || !base) {
         printf("❌ ERRORE: Impossibile allocare memoria\n");
@@ -266,6 +830,14 @@ int main() {
     // Leggi file
     float unit_conv = input_is_g ? G_TO_MS2 : 1.0f;
     
+    // Cache dei segnali filtrati solo per l'analisi offline: streaming e
+    // replay elaborano acc campione per campione
+    if (stream_mode || replay.speed > 0.0) use_cache = 0;
+    FilterCache cache = {0};
+    uint64_t cache_key = 0;
+    int cache_hit = 0;
+    int cache_saved = 0;
+    
     printf("\n========== CARICAMENTO DATI ==========\n");
     printf("File accelerazioni TOP (tetto/sommità edificio): ");
     if (scanf("%255s", filein_top) != 1) {
@@ -273,35 +845,82 @@ int main() {
         free_signal_data(top);
         free_signal_data(base);
         cleanup_filter_config(&filter);
+        cleanup_decimator(&decimator);
         return 1;
     }
     
-    int n_top = read_acceleration_file(filein_top, top->acc, 
-                                       MAX_SAMPLES, unit_conv);
-    if (n_top < 0) {
-        printf("❌ Impossibile leggere il file TOP\n");
-        free_signal_data(top);
-        free_signal_data(base);
-        cleanup_filter_config(&filter);
-        return 1;
+    // La lettura di TOP procede in un task mentre si attende il nome BASE;
+    // con la cache il task legge il file una volta e ne calcola l'impronta,
+    // il parsing attende la verifica della chiave
+    int n_top = -1, n_base = -1;
+    int have_base = 0;
+    int base_channel = 0;
+    ChannelSource src_top = {0}, src_base = {0};
+    #pragma omp parallel
+    #pragma omp single
+    {
+        #pragma omp task
+        {
+            if (!use_cache) {
+                n_top = load_channel(filein_top, 0, top, &wf_top, unit_conv, fs);
+            } else if (open_channel_source(&src_top, filein_top, &wf_top)) {
+                n_top = 0;
+            }
+        }
+        
+        printf("File accelerazioni BASE (fondazione/base edificio): ");
+        fflush(stdout);
+        if (scanf("%255s", filein_base) == 1) {
+            have_base = 1;
+            base_channel = (strcmp(filein_base, filein_top) == 0) ? 1 : 0;
+            #pragma omp task
+            {
+                if (!use_cache) {
+                    n_base = load_channel(filein_base, base_channel, base,
+                                          &wf_base, unit_conv, fs);
+                } else if (open_channel_source(&src_base, filein_base, &wf_base)) {
+                    n_base = 0;
+                }
+            }
+        }
     }
     
-    printf("File accelerazioni BASE (fondazione/base edificio): ");
-    if (scanf("%255s", filein_base) != 1) {
-        printf("❌ ERRORE di input\n");
-        free_signal_data(top);
-        free_signal_data(base);
-        cleanup_filter_config(&filter);
-        return 1;
+    // Con la cache i file sono già in memoria con la loro impronta: se la
+    // chiave è valida niente parsing, altrimenti si analizza lo stesso buffer
+    if (use_cache && have_base && n_top >= 0 && n_base >= 0) {
+        cache_key = filter_cache_key(src_top.hash, src_base.hash, base_channel,
+                                     fs, unit_conv, &filter);
+        int n_cached = filter_cache_load(&cache, cache_key, &filter, top, base);
+        if (n_cached > 0) {
+            cache_hit = 1;
+            n_top = n_base = n_cached;
+            printf("\n✓ Cache filtri: %s (parsing, decimazione e filtraggio "
+                   "saltati)\n", cache.path);
+        } else {
+            #pragma omp parallel sections
+            {
+                #pragma omp section
+                n_top = load_channel_source(&src_top, 0, top, &wf_top,
+                                            unit_conv, fs);
+                #pragma omp section
+                n_base = load_channel_source(&src_base, base_channel, base,
+                                             &wf_base, unit_conv, fs);
+            }
+        }
     }
+    close_channel_source(&src_top);
+    close_channel_source(&src_base);
     
-    int n_base = read_acceleration_file(filein_base, base->acc,
-                                        MAX_SAMPLES, unit_conv);
-    if (n_base < 0) {
-        printf("❌ Impossibile leggere il file BASE\n");
+    if (!have_base || n_top < 0 || n_base < 0) {
+        if (!have_base) printf("❌ ERRORE di input\n");
+        if (n_top < 0) printf("❌ Impossibile leggere il file TOP\n");
+        if (have_base && n_base < 0) printf("❌ Impossibile leggere il file BASE\n");
         free_signal_data(top);
         free_signal_data(base);
+        waveform_close(&wf_top);
+        waveform_close(&wf_base);
         cleanup_filter_config(&filter);
+        cleanup_decimator(&decimator);
         return 1;
     }
     
@@ -314,25 +933,49 @@ int main() {
     top->n_samples = base->n_samples = n;
     
     // Statistiche
-    float pga_top = calculate_pga(top->acc, n);
-    float pga_base = calculate_pga(base->acc, n);
-    print_input_statistics(n, filter.dt, pga_top, pga_base);
+    float pga_top = calculate_pga(top->acc, n) * top->acc_scale;
+    float pga_base = calculate_pga(base->acc, n) * base->acc_scale;
+    // Dalla cache i canali sono già decimati a fs_proc
+    print_input_statistics(n, 1.0f / (cache_hit ? fs_proc : fs), pga_top, pga_base);
     
-    // Prepara nomi file output
-    snprintf(fileout_csv, sizeof(fileout_csv), "%s_results.csv", filein_top);
-    snprintf(fileout_debug, sizeof(fileout_debug), "%s_debug.txt", filein_top);
+    if (decimate_fs && !cache_hit) {
+        if (!decimate_channels(&decimator, &top, &base, &n)) {
+            printf("❌ ERRORE: Impossibile allocare memoria\n");
+            goto cleanup;
+        }
+        printf("✓ Decimati a %d Hz: %d campioni per canale\n", fs_proc, n);
+    }
     
-    // Elaborazione segnali
-    printf("\n========== ELABORAZIONE SEGNALI ==========\n");
-    printf("Applicazione filtri high-pass e FIR...\n");
+    if (stream_mode) {
+        if (fragility) printf("⚠ Matrice di fragilità non disponibile in streaming\n");
+        AlarmThreshold stream_threshold = {building_type, damage_state,
+                                           drift_limit, prob_threshold};
+        LivePublisher live_pub;
+        LivePublisher *live = open_live_state(&live_pub, live_name, filter.fs,
+                                              &stream_threshold, building_height);
+        run_stream_mode(top, base, n, &filter, sta_s, lta_s, ptm_s,
+                        building_height, &stream_threshold, live);
+        if (live) live_publisher_close(live);
+        goto cleanup;
+    }
     
-    apply_highpass_filter(top->acc, top->acc_hp, n, filter.hp_a, filter.hp_b);
-    apply_fir_filter(top->acc_hp, top->acc_fir, n, filter.kernel, filter.filter_len);
+    if (replay.speed > 0.0) {
+        AlarmThreshold replay_threshold = {building_type, damage_state,
+                                           drift_limit, prob_threshold};
+        LivePublisher live_pub;
+        replay.live = open_live_state(&live_pub, live_name, filter.fs,
+                                      &replay_threshold, building_height);
+        run_replay_mode(top, base, n, &filter, sta_s, lta_s, ptm_s,
+                        building_height, &replay_threshold, &replay);
+        if (replay.live) live_publisher_close(replay.live);
+        goto cleanup;
+    }
     
-    apply_highpass_filter(base->acc, base->acc_hp, n, filter.hp_a, filter.hp_b);
-    apply_fir_filter(base->acc_hp, base->acc_fir, n, filter.kernel, filter.filter_len);
+    if (live_name) printf("⚠ --live richiede --stream o --replay: ignorato\n");
     
-    printf("✓ Filtri applicati con successo\n");
+    // Prepara nomi file output
+    snprintf(fileout_debug, sizeof(fileout_debug), "%s_debug.txt", filein_top);
+    trace_opt.filename = fileout_debug;
     
     // Prepara struttura soglie allarme
     AlarmThreshold alarm_threshold;
@@ -341,55 +984,166 @@ int main() {
     alarm_threshold.drift_limit = drift_limit;
     alarm_threshold.prob_threshold = prob_threshold;
     
-    // Trigger
-    printf("\n========== RICERCA TRIGGER ==========\n");
-    printf("Parametri: STA=%.1fs, LTA=%.1fs, Soglia=4.0\n", sta_s, lta_s);
+    // Matrice di fragilità: tutte le soglie sullo stesso PGD base
+    FragilityMatrix matrix;
+    if (fragility) fragility_init(&matrix, thresholds, NUM_THRESHOLDS);
+    FragilityMatrix *matrix_ptr = fragility ? &matrix : NULL;
     
     TriggerParams trigger;
     init_trigger_params(&trigger, sta_s, lta_s);
     
-    if (!find_trigger(top->acc_fir, n, &trigger, &filter)) {
+    AnalysisResults results;
+    int triggered;
+    
+    if (fused && trigger_bank) {
+        printf("⚠ Il banco rivelatori richiede acc_fir completo: "
+               "uso la pipeline a stadi\n");
+        fused = 0;
+    }
+    
+    if (fused && cache_hit) {
+        printf("⚠ Filtri già in cache: uso la pipeline a stadi\n");
+        fused = 0;
+    }
+    
+    if (fused && fused_pipeline_supported(&filter, n)) {
+        // Un solo passaggio a blocchi; array intermedi solo per il CSV
+        printf("\n========== PIPELINE FUSA ==========\n");
+        printf("Blocchi da %d campioni: HP, FIR, STA/LTA e drift insieme\n",
+               FIR_DIRECT_CHUNK);
+        printf("Parametri: STA=%.1fs, LTA=%.1fs, Soglia=%.1f, PTM=%.1fs\n",
+               sta_s, lta_s, trigger.threshold, ptm_s);
+        triggered = run_fused_pipeline(top, base, n, &filter, &trigger, ptm_s,
+                                       building_height, &alarm_threshold,
+                                       &results, &trace_opt, matrix_ptr,
+                                       write_csv);
+    } else {
+        if (fused) {
+            printf("⚠ Pipeline fusa non applicabile (FIR via FFT o ricorsivo, "
+                   "HP con scan parallela), "
+                   "uso quella a stadi\n");
+        }
+        
+        // Elaborazione segnali come grafo di task: HP e FIR di TOP e BASE
+        // in parallelo; il trigger attende solo il FIR TOP e l'analisi drift
+        // solo trigger e HP dei due canali (il FIR BASE non ha consumatori a valle)
+        // Con la cache valida gli stadi di filtro sono già pronti; altrimenti
+        // il salvataggio in cache attende i quattro filtri e procede in
+        // parallelo all'analisi
+        printf("\n========== ELABORAZIONE SEGNALI ==========\n");
+        if (cache_hit) {
+            printf("Filtri high-pass e FIR (TOP e BASE) dalla cache\n");
+        } else {
+            printf("Applicazione filtri high-pass e FIR (TOP e BASE in parallelo)...\n");
+        }
+        
+        triggered = 0;
+        #pragma omp parallel
+        #pragma omp single
+        {
+            #pragma omp task depend(out: top->acc_hp[0])
+            if (!cache_hit) {
+                apply_highpass_filter(top->acc, top->acc_hp, n, filter.hp_a,
+                                      filter.hp_b * top->acc_scale);
+            }
+            
+            #pragma omp task depend(out: base->acc_hp[0])
+            if (!cache_hit) {
+                apply_highpass_filter(base->acc, base->acc_hp, n, filter.hp_a,
+                                      filter.hp_b * base->acc_scale);
+            }
+            
+            #pragma omp task depend(in: top->acc_hp[0]) depend(out: top->acc_fir[0])
+            if (!cache_hit) apply_gaussian_smoothing(top->acc_hp, top->acc_fir, n, &filter);
+            
+            #pragma omp task depend(in: base->acc_hp[0]) depend(out: base->acc_fir[0])
+            if (!cache_hit) apply_gaussian_smoothing(base->acc_hp, base->acc_fir, n, &filter);
+            
+            #pragma omp task depend(in: top->acc_fir[0], base->acc_fir[0])
+            if (use_cache && cache_key && !cache_hit) {
+                cache_saved = filter_cache_store(&cache, cache_key, &filter,
+                                                 top, base, n);
+            }
+            
+            #pragma omp task depend(in: top->acc_fir[0]) depend(out: trigger)
+            {
+                printf("✓ Filtri TOP applicati\n");
+                
+                // Trigger
+                printf("\n========== RICERCA TRIGGER ==========\n");
+                printf("Parametri: STA=%.1fs, LTA=%.1fs, Soglia=%.1f\n", sta_s, lta_s,
+                       trigger.threshold);
+                
+                triggered = find_trigger(top->acc_fir, n, &trigger, &filter);
+                
+                if (trigger_bank) {
+                    report_trigger_bank(top->acc_fir, n, &filter, &trigger,
+                                        have_bank_thresholds ? bank_thresholds : NULL,
+                                        filein_top);
+                }
+            }
+            
+            #pragma omp task depend(in: trigger, top->acc_hp[0], base->acc_hp[0])
+            if (triggered) {
+                // Analisi drift post-trigger
+                printf("\n========== ANALISI DRIFT POST-TRIGGER ==========\n");
+                printf("Finestra analisi: %.1f secondi\n", ptm_s);
+                printf("Altezza normalizzazione: %.2f m (2/3 di %.1f m)\n", 
+                       (2.0f/3.0f) * building_height, building_height);
+                
+                perform_drift_analysis(top, base, &trigger, &filter, ptm_s,
+                                      building_height, &alarm_threshold,
+                                      &results, &trace_opt, matrix_ptr);
+            }
+        }
+        
+        if (cache_saved) printf("✓ Cache filtri salvata: %s\n", cache.path);
+    }
+    
+    if (!triggered) {
         printf("\n========== RISULTATO ==========\n");
         printf("⚪ Nessun evento sismico rilevato\n");
         printf("   (Rapporto STA/LTA non supera la soglia di trigger)\n");
         goto cleanup;
     }
     
-    // Analisi drift post-trigger
-    printf("\n========== ANALISI DRIFT POST-TRIGGER ==========\n");
-    printf("Finestra analisi: %.1f secondi\n", ptm_s);
-    printf("Altezza normalizzazione: %.2f m (2/3 di %.1f m)\n", 
-           (2.0f/3.0f) * building_height, building_height);
-    
-    AnalysisResults results;
-    perform_drift_analysis(top, base, &trigger, &filter, ptm_s,
-                          building_height, &alarm_threshold,
-                          &results, fileout_debug);
-    
     // Report finale
     print_final_report(&results, &alarm_threshold);
     
-    // Salva risultati completi
-    printf("\n========== SALVATAGGIO RISULTATI ==========\n");
-    
-    float *drift = (float*)malloc(n * sizeof(float));
-    float *drift_norm = (float*)malloc(n * sizeof(float));
-    
-    if (drift && drift_norm) {
-        float norm_height = (2.0f / 3.0f) * building_height;
-        for (int i = 0; i < n; i++) {
-            drift[i] = top->disp[i] - base->disp[i];
-            drift_norm[i] = drift[i] / norm_height;
+    if (fragility) {
+        print_fragility_matrix(&matrix, filter.dt);
+        char fileout_matrix[300];
+        snprintf(fileout_matrix, sizeof(fileout_matrix), "%s_matrix.csv", filein_top);
+        if (write_fragility_csv(fileout_matrix, &matrix, filter.dt)) {
+            printf("✓ Matrice di fragilità: %s\n", fileout_matrix);
+        } else {
+            printf("❌ ERRORE: Scrittura fallita su %s\n", fileout_matrix);
         }
+    }
+    
+    // Scrittura in background: lo stato finale non attende il disco
+    ResultsWriter writer;
+    if (write_csv) {
+        printf("\n========== SALVATAGGIO RISULTATI ==========\n");
         
-        write_results(fileout_csv, top, base, drift, drift_norm, n,
-                      filter.dt, results.alarm_idx);
-        
-        printf("✓ File risultati: %s\n", fileout_csv);
-        printf("✓ File debug: %s\n", fileout_debug);
-        
-        free(drift);
-        free(drift_norm);
+        snprintf(writer.filename, sizeof(writer.filename), "%s_results.%s",
+                 filein_top, results_binary ? "dwsf" : "csv");
+        writer.format = results_binary ? RESULTS_BINARY : RESULTS_CSV;
+        writer.disp_top = top->disp;
+        writer.disp_base = base->disp;
+        writer.norm_height = (2.0f / 3.0f) * building_height;
+        writer.dt = filter.dt;
+        writer.fs = filter.fs;
+        writer.start = 0;
+        writer.end = n;
+        if (results_window) {
+            writer.start = trigger.trigger_idx;
+            writer.end = trigger.trigger_idx + (int)(ptm_s * filter.fs);
+            if (writer.end > n) writer.end = n;
+        }
+        writer.alarm_idx = results.alarm_idx;
+        write_results(&writer, 1);
+        printf("Scrittura %s in background...\n", writer.filename);
     }
     
     printf("\n==========================================================\n");
@@ -400,10 +1154,22 @@ int main() {
     }
     printf("==========================================================\n");
     
+    if (write_csv && wait_results(&writer)) {
+        printf("✓ File risultati: %s (righe %d-%d)\n", writer.filename,
+               writer.start + 1, writer.end);
+    } else if (write_csv) {
+        printf("❌ ERRORE: Scrittura fallita su %s\n", writer.filename);
+    }
+    printf("✓ File debug: %s\n", fileout_debug);
+    
 cleanup:
     free_signal_data(top);
     free_signal_data(base);
+    waveform_close(&wf_top);
+    waveform_close(&wf_base);
     cleanup_filter_config(&filter);
+    cleanup_decimator(&decimator);
+    filter_cache_close(&cache);
     
     return 0;
 }
\ No newline at end of file
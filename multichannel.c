@@ -0,0 +1,377 @@
+#include "multichannel.h"
+#include "config.h"
+#include "filters.h"
+#include "signal_processing.h"
+#include "trigger.h"
+#include "drift_analysis.h"
+#include "waveform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#define MC_LANE_ALIGN 16          // Lane per riga: multipla di un vettore a 512 bit
+
+extern const char *building_keys[];
+extern const char *damage_keys[];
+
+static void free_state(MultiState *st) {
+    free(st->hp_b);
+    free(st->x_prev);
+    free(st->acc_hp);
+    free(st->vel_unf);
+    free(st->vel_filt);
+    free(st->disp);
+    free(st->block);
+    free(st->storey);
+}
+
+static float* lane_array(int count) {
+    return (float*)aligned_alloc(64, (size_t)count * sizeof(float));
+}
+
+static int init_state(MultiState *st, const MultiLayout *lay, float hp_b) {
+    memset(st, 0, sizeof(*st));
+    st->n_lanes = lay->n_floors * lay->n_horiz;
+    st->stride = (st->n_lanes + MC_LANE_ALIGN - 1) & ~(MC_LANE_ALIGN - 1);
+
+    st->hp_b = lane_array(st->stride);
+    st->x_prev = lane_array(st->stride);
+    st->acc_hp = lane_array(st->stride);
+    st->vel_unf = lane_array(st->stride);
+    st->vel_filt = lane_array(st->stride);
+    st->disp = lane_array(st->stride);
+    st->block = lane_array(st->stride * MC_BLOCK);
+    st->storey = lane_array(MC_MAX_FLOORS);
+    if (!st->hp_b || !st->x_prev || !st->acc_hp || !st->vel_unf ||
+        !st->vel_filt || !st->disp || !st->block || !st->storey) {
+        free_state(st);
+        return 0;
+    }
+
+    // Lane di riempimento: ingresso e guadagno nulli, restano a zero
+    for (int k = 0; k < st->stride; k++) {
+        st->hp_b[k] = (k < st->n_lanes) ? hp_b : 0.0f;
+        st->x_prev[k] = st->acc_hp[k] = 0.0f;
+        st->vel_unf[k] = st->vel_filt[k] = st->disp[k] = 0.0f;
+    }
+    memset(st->block, 0, (size_t)st->stride * MC_BLOCK * sizeof(float));
+    return 1;
+}
+
+// Trasposizione di un blocco: block[t][lane] = canale(lane)[i0 + t]
+static void load_block(MultiState *st, const float *const *lanes, int i0,
+                       int count) {
+    for (int k = 0; k < st->n_lanes; k++) {
+        const float *src = lanes[k] + i0;
+        float *dst = st->block + k;
+        for (int t = 0; t < count; t++) {
+            dst[(size_t)t * st->stride] = src[t];
+        }
+    }
+}
+
+// HP su tutte le lane, stesse operazioni di apply_highpass_filter
+static void lanes_highpass(MultiState *st, const float *x, float hp_a) {
+    float *restrict xp = st->x_prev;
+    float *restrict y = st->acc_hp;
+    const float *restrict hb = st->hp_b;
+
+    #pragma omp simd aligned(x, xp, y, hb : 64)
+    for (int k = 0; k < st->stride; k++) {
+        float h = x[k] * hb[k] - xp[k] * hb[k] + hp_a * y[k];
+        xp[k] = x[k];
+        y[k] = h;
+    }
+}
+
+// HP e integrazioni acc -> vel -> HP -> spostamento su tutte le lane,
+// stesse operazioni di drift_monitor_step
+static void lanes_integrate(MultiState *st, const float *x,
+                            const FilterConfig *f) {
+    float *restrict xp = st->x_prev;
+    float *restrict y = st->acc_hp;
+    float *restrict vu = st->vel_unf;
+    float *restrict vf = st->vel_filt;
+    float *restrict d = st->disp;
+    const float *restrict hb = st->hp_b;
+    float hp_a = f->hp_a, hp_b = f->hp_b, dt = f->dt;
+
+    #pragma omp simd aligned(x, xp, y, vu, vf, d, hb : 64)
+    for (int k = 0; k < st->stride; k++) {
+        float h = x[k] * hb[k] - xp[k] * hb[k] + hp_a * y[k];
+        float vel_unf = vu[k] + (y[k] + h) * 0.5f * dt;
+        float vel_filt = vel_unf * hp_b - vu[k] * hp_b + hp_a * vf[k];
+        d[k] = d[k] + (vf[k] + vel_filt) * 0.5f * dt;
+        vu[k] = vel_unf;
+        vf[k] = vel_filt;
+        xp[k] = x[k];
+        y[k] = h;
+    }
+}
+
+// Drift per interpiano e massimi; ritorna il PGD base (risultante)
+static float update_storeys(MultiState *st, const MultiLayout *lay,
+                            MultiResults *mr, int i) {
+    const float *d = st->disp;
+    float *r = st->storey;
+    int nh = lay->n_horiz;
+
+    if (nh == 2) {
+        #pragma omp simd
+        for (int s = 1; s < lay->n_floors; s++) {
+            float dx = d[2*s] - d[2*s - 2];
+            float dy = d[2*s + 1] - d[2*s - 1];
+            r[s] = sqrtf(dx * dx + dy * dy);
+        }
+    } else {
+        #pragma omp simd
+        for (int s = 1; s < lay->n_floors; s++) {
+            r[s] = fabsf(d[s] - d[s - 1]);
+        }
+    }
+
+    for (int s = 1; s < lay->n_floors; s++) {
+        if (r[s] > mr->max_resultant[s]) {
+            mr->max_resultant[s] = r[s];
+            mr->max_idx[s] = i;
+        }
+        for (int c = 0; c < nh; c++) {
+            float a = fabsf(d[s*nh + c] - d[(s-1)*nh + c]);
+            if (a > mr->max_drift[s][c]) mr->max_drift[s][c] = a;
+        }
+    }
+
+    int top = (lay->n_floors - 1) * nh;
+    float rx = d[top] - d[0];
+    float ry = (nh == 2) ? d[top + 1] - d[1] : 0.0f;
+    float roof = (nh == 2) ? sqrtf(rx * rx + ry * ry) : fabsf(rx);
+    if (roof > mr->max_roof) mr->max_roof = roof;
+
+    return (nh == 2) ? sqrtf(d[0] * d[0] + d[1] * d[1]) : fabsf(d[0]);
+}
+
+// HP dall'inizio del record, integrazioni da start (trigger) a end esclusa
+static void analyse_lanes(MultiState *st, const MultiLayout *lay,
+                          const float *const *lanes, int start, int end,
+                          const FilterConfig *filter,
+                          const AlarmThreshold *threshold, MultiResults *mr) {
+    AnalysisResults *res = &mr->results;
+    float pgd_crit = pgd_critical(threshold->drift_limit,
+                                  threshold->prob_threshold);
+
+    for (int i0 = 0; i0 < end; i0 += MC_BLOCK) {
+        int count = (end - i0 < MC_BLOCK) ? end - i0 : MC_BLOCK;
+        load_block(st, lanes, i0, count);
+
+        for (int t = 0; t < count; t++) {
+            int i = i0 + t;
+            const float *x = st->block + (size_t)t * st->stride;
+
+            if (i == 0) {
+                // Primo campione: uscita HP nulla, come apply_highpass_filter
+                memcpy(st->x_prev, x, st->stride * sizeof(float));
+                continue;
+            }
+            if (i <= start) {
+                lanes_highpass(st, x, filter->hp_a);
+                continue;
+            }
+
+            lanes_integrate(st, x, filter);
+            float pgd = update_storeys(st, lay, mr, i);
+            if (pgd > res->pgd_base) {
+                res->pgd_base = pgd;
+                int alarm = (pgd_crit >= 0.0f)
+                            ? pgd >= pgd_crit
+                            : calculate_exceedance_probability(pgd,
+                                  threshold->drift_limit) > threshold->prob_threshold;
+                if (!res->alarm_triggered && alarm) {
+                    res->alarm_triggered = 1;
+                    res->alarm_idx = i;
+                }
+            }
+        }
+    }
+}
+
+static int write_multi_summary(const char *filename, const MultiLayout *lay,
+                               const MultiResults *mr, float dt, int start) {
+    FILE *fp = fopen(filename, "w");
+    if (!fp) return 0;
+
+    fprintf(fp, "# Interpiano, Quota_inf(m), Quota_sup(m), Drift_X(m), Drift_Y(m), "
+                "Drift_ris(m), Rapporto(mm/m), T_max(s)\n");
+    for (int s = 1; s < lay->n_floors; s++) {
+        float h = lay->elevation[s] - lay->elevation[s-1];
+        fprintf(fp, "%d, %.2f, %.2f, %.6e, %.6e, %.6e, %.3f, %.3f\n", s,
+                lay->elevation[s-1], lay->elevation[s], mr->max_drift[s][0],
+                lay->n_horiz == 2 ? mr->max_drift[s][1] : 0.0f,
+                mr->max_resultant[s], mr->max_resultant[s] / h * 1000.0f,
+                mr->max_idx[s] >= 0 ? (mr->max_idx[s] - start) * dt : 0.0f);
+    }
+    return fclose(fp) == 0;
+}
+
+static void print_multi_report(const MultiLayout *lay, const MultiResults *mr,
+                               float dt, int start,
+                               const AlarmThreshold *threshold) {
+    const AnalysisResults *res = &mr->results;
+
+    printf("\n========== DRIFT INTERPIANO ==========\n");
+    printf("%-11s %15s %11s %11s %11s %10s %8s\n", "Interpiano", "Quote (m)",
+           "Drift X(m)", "Drift Y(m)", "Ris. (m)", "mm/m", "T max");
+    for (int s = 1; s < lay->n_floors; s++) {
+        float h = lay->elevation[s] - lay->elevation[s-1];
+        printf("  %2d (%d-%d) %7.2f-%-7.2f %11.5f ", s, s - 1, s,
+               lay->elevation[s-1], lay->elevation[s], mr->max_drift[s][0]);
+        if (lay->n_horiz == 2) printf("%11.5f ", mr->max_drift[s][1]);
+        else printf("%11s ", "-");
+        printf("%11.5f %10.2f ", mr->max_resultant[s],
+               mr->max_resultant[s] / h * 1000.0f);
+        if (mr->max_idx[s] >= 0) printf("%7.2fs\n", (mr->max_idx[s] - start) * dt);
+        else printf("%8s\n", "-");
+    }
+
+    printf("\n========== REPORT FINALE ==========\n");
+    printf("PGD base (risultante orizzontale): %.5f m\n", res->pgd_base);
+    printf("Drift sommità-base: %.5f m (%.2f mm/m)\n", res->max_drift_abs,
+           res->max_drift_norm * 1000);
+    printf("Probabilità massima: %.2f%% (soglia %.2f%%)\n",
+           res->max_prob * 100.0f, threshold->prob_threshold * 100.0f);
+    if (res->alarm_triggered) {
+        printf("\n✓ ALLARME ATTIVATO: %.3f s dopo trigger (indice %d)\n",
+               (res->alarm_idx - start) * dt, res->alarm_idx);
+    } else {
+        printf("\n✗ NESSUN ALLARME\n");
+    }
+}
+
+int run_multichannel(const char *filename, BuildingType type,
+                     DamageState state, const float *elevations,
+                     int n_elevations, const char *summary_file) {
+    MultiLayout lay;
+    lay.n_floors = n_elevations + 1;
+    if (n_elevations < 1 || lay.n_floors > MC_MAX_FLOORS) {
+        printf("ERRORE: servono da 1 a %d quote di piano\n", MC_MAX_FLOORS - 1);
+        return 0;
+    }
+    lay.elevation[0] = 0.0f;
+    for (int f = 1; f < lay.n_floors; f++) {
+        lay.elevation[f] = elevations[f-1];
+        if (lay.elevation[f] <= lay.elevation[f-1]) {
+            printf("ERRORE: quote dei piani non crescenti (%.2f m)\n",
+                   lay.elevation[f]);
+            return 0;
+        }
+    }
+
+    AlarmThreshold threshold = {type, state, 0.0f, 0.0f};
+    if (!get_alarm_thresholds(type, state, &threshold.drift_limit,
+                              &threshold.prob_threshold)) {
+        printf("ERRORE: Soglie non trovate per la configurazione selezionata\n");
+        return 0;
+    }
+
+    WaveformFile wf = {0};
+    if (!waveform_open(&wf, filename)) return 0;
+
+    int n_channels = (int)wf.hdr.n_channels;
+    if (n_channels % lay.n_floors != 0 || n_channels / lay.n_floors > 3) {
+        printf("ERRORE: %s ha %d canali, non divisibili in %d piani "
+               "da 1-3 componenti\n", filename, n_channels, lay.n_floors);
+        waveform_close(&wf);
+        return 0;
+    }
+    lay.n_comp = n_channels / lay.n_floors;
+    lay.n_horiz = (lay.n_comp < MC_MAX_HORIZ) ? lay.n_comp : MC_MAX_HORIZ;
+
+    int fs = (int)wf.hdr.fs;
+    int n = (wf.hdr.n_samples > MAX_SAMPLES) ? MAX_SAMPLES : (int)wf.hdr.n_samples;
+    float scale = waveform_unit_scale(&wf);
+
+    FilterConfig filter;
+    init_filter_config(&filter, fs);
+    if (filter.hp_a == 0.0f) {
+        printf("❌ ERRORE: Frequenza non supportata (%d Hz)\n", fs);
+        cleanup_filter_config(&filter);
+        waveform_close(&wf);
+        return 0;
+    }
+
+    printf("\n========== ANALISI MULTI-PIANO ==========\n");
+    printf("File: %s (%d Hz, %d campioni)\n", filename, fs, n);
+    printf("Piani: %d, componenti per piano: %d (%d orizzontali)\n",
+           lay.n_floors, lay.n_comp, lay.n_horiz);
+    printf("Edificio: %s, danno: %s\n", building_keys[type], damage_keys[state]);
+
+    // Trigger sul canale X dell'ultimo piano, come il TOP a due canali
+    TriggerParams trigger;
+    init_trigger_params(&trigger, STA_WINDOW_S, LTA_WINDOW_S);
+    int ref_channel = (lay.n_floors - 1) * lay.n_comp;
+    SignalData *ref = create_signal_data(n);
+    int ok = ref != NULL;
+    int triggered = 0;
+    if (ok) {
+        attach_external_acc(ref, waveform_channel(&wf, ref_channel), scale);
+        apply_highpass_filter(ref->acc, ref->acc_hp, n, filter.hp_a,
+                              filter.hp_b * ref->acc_scale);
+        apply_gaussian_smoothing(ref->acc_hp, ref->acc_fir, n, &filter);
+        triggered = find_trigger(ref->acc_fir, n, &trigger, &filter);
+        free_signal_data(ref);
+    }
+
+    MultiState st;
+    if (ok && triggered && !init_state(&st, &lay, filter.hp_b * scale)) ok = 0;
+
+    if (ok && triggered) {
+        const float *lanes[MC_MAX_FLOORS * MC_MAX_HORIZ];
+        for (int f = 0; f < lay.n_floors; f++) {
+            for (int c = 0; c < lay.n_horiz; c++) {
+                lanes[f * lay.n_horiz + c] = waveform_channel(&wf, f * lay.n_comp + c);
+            }
+        }
+
+        int start = trigger.trigger_idx;
+        int end = start + (int)(PTM_WINDOW_S * fs);
+        if (end > n) end = n;
+
+        MultiResults mr;
+        memset(&mr, 0, sizeof(mr));
+        mr.results.alarm_idx = -1;
+        for (int f = 0; f < MC_MAX_FLOORS; f++) mr.max_idx[f] = -1;
+
+        double t0 = omp_get_wtime();
+        analyse_lanes(&st, &lay, lanes, start, end, &filter, &threshold, &mr);
+        double elapsed = omp_get_wtime() - t0;
+
+        float roof_height = lay.elevation[lay.n_floors - 1];
+        mr.results.max_drift_abs = mr.max_roof;
+        mr.results.max_drift_norm = mr.max_roof / roof_height;
+        mr.results.max_prob = calculate_exceedance_probability(
+            mr.results.pgd_base, threshold.drift_limit);
+
+        print_multi_report(&lay, &mr, filter.dt, start, &threshold);
+        printf("Elaborazione: %.2f ms, %.1f ns/campione per %d lane\n",
+               elapsed * 1e3, elapsed * 1e9 / end, st.n_lanes);
+
+        if (summary_file) {
+            if (write_multi_summary(summary_file, &lay, &mr, filter.dt, start)) {
+                printf("✓ Riepilogo interpiani: %s\n", summary_file);
+            } else {
+                printf("❌ ERRORE: Scrittura fallita su %s\n", summary_file);
+                ok = 0;
+            }
+        }
+        free_state(&st);
+    } else if (!ok) {
+        printf("❌ ERRORE: Memoria insufficiente per l'analisi multi-piano\n");
+    } else {
+        printf("⚪ Nessun evento sismico rilevato\n");
+    }
+
+    cleanup_filter_config(&filter);
+    waveform_close(&wf);
+    return ok;
+}
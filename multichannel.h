@@ -0,0 +1,49 @@
+#ifndef MULTICHANNEL_H
+#define MULTICHANNEL_H
+
+#include "types.h"
+
+#define MC_MAX_FLOORS 64
+#define MC_MAX_HORIZ 2            // Componenti orizzontali usate per il drift
+#define MC_BLOCK 256              // Campioni per blocco trasposto
+
+// Rete multi-piano in un unico .dwsf: canali piano per piano (piano 0 =
+// fondazione), n_comp componenti per piano nell'ordine X, Y, Z
+typedef struct {
+    int n_floors;
+    int n_comp;                       // Componenti per piano nel file (1-3)
+    int n_horiz;                      // Componenti orizzontali (1-2)
+    float elevation[MC_MAX_FLOORS];   // Quota del piano sulla base (m)
+} MultiLayout;
+
+// Stato SoA: una lane per canale orizzontale, lane = piano * n_horiz + comp.
+// Tutte le lane avanzano insieme, un campione alla volta
+typedef struct {
+    int n_lanes;
+    int stride;                       // n_lanes arrotondato al vettore
+    float *hp_b;                      // hp_b con il fattore di unità
+    float *x_prev;                    // Ultimo ingresso del filtro HP
+    float *acc_hp;                    // Ultima uscita HP
+    float *vel_unf, *vel_filt, *disp;
+    float *block;                     // MC_BLOCK campioni trasposti [t][lane]
+    float *storey;                    // Drift risultante per interpiano
+} MultiState;
+
+// Massimi sulla finestra post-trigger, indicizzati per interpiano s
+// (tra i piani s-1 e s, s >= 1)
+typedef struct {
+    float max_drift[MC_MAX_FLOORS][MC_MAX_HORIZ];   // |drift| per componente (m)
+    float max_resultant[MC_MAX_FLOORS];             // Drift risultante (m)
+    int max_idx[MC_MAX_FLOORS];                     // Campione del massimo
+    float max_roof;                   // Risultante sommità - base (m)
+    AnalysisResults results;          // PGD base (risultante) e allarme
+} MultiResults;
+
+// Analisi completa di un .dwsf multi-canale: trigger sul canale X
+// dell'ultimo piano, poi HP e integrazioni di tutti i canali in parallelo
+// sulle lane SIMD. elevations: quote dei piani 1..n-1 sulla base
+int run_multichannel(const char *filename, BuildingType type,
+                     DamageState state, const float *elevations,
+                     int n_elevations, const char *summary_file);
+
+#endif
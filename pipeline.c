@@ -0,0 +1,181 @@
+#include "pipeline.h"
+#include "config.h"
+#include "filters.h"
+#include "fir_simd.h"
+#include "trigger.h"
+#include "drift_analysis.h"
+#include "scan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Finestra scorrevole su un segnale: buf[j] è il campione origin + j.
+// Contiene gli ultimi hist campioni e il blocco corrente
+typedef struct {
+    float *buf;
+    int hist;
+    int origin;
+} TileWindow;
+
+static int window_init(TileWindow *w, int hist, int origin) {
+    w->hist = hist;
+    w->origin = origin;
+    w->buf = (float*)calloc(hist + FIR_DIRECT_CHUNK, sizeof(float));
+    return w->buf != NULL;
+}
+
+// Prepara la finestra per il blocco che inizia in a (dati validi fino ad a)
+static void window_advance(TileWindow *w, int a) {
+    int origin = a - w->hist;
+    if (origin <= w->origin) return;
+    memmove(w->buf, w->buf + (origin - w->origin), w->hist * sizeof(float));
+    w->origin = origin;
+}
+
+static float* window_at(TileWindow *w, int i) {
+    return w->buf + (i - w->origin);
+}
+
+// Stesse operazioni di apply_highpass_filter sugli indici [a, b)
+static void highpass_tile(const float *input, TileWindow *w, int a, int b,
+                          float hp_a, float hp_b) {
+    int i = a;
+    if (i == 0) {
+        *window_at(w, 0) = 0.0f;
+        i = 1;
+    }
+    float prev = *window_at(w, i - 1);
+    for (; i < b; i++) {
+        prev = input[i] * hp_b - input[i-1] * hp_b + hp_a * prev;
+        *window_at(w, i) = prev;
+    }
+}
+
+int fused_pipeline_supported(FilterConfig *filter, int n) {
+    if (filter->fir_mode != FIR_MODE_EXACT) return 0;
+    // I blocchi fusi applicano l'HP in serie: con la scan parallela
+    // l'acc_hp a stadi arrotonda diversamente
+    if (scan_parallel_enabled(n)) return 0;
+    // Ingresso del FIR a stadi: n - offset campioni, kernel potato
+    return select_fir_fft_block(n - filter->kernel_offset,
+                                filter->kernel_eff_len) == 0;
+}
+
+int run_fused_pipeline(SignalData *top, SignalData *base, int n,
+                       FilterConfig *filter, TriggerParams *trigger,
+                       float ptm_len_s, float building_height,
+                       AlarmThreshold *threshold, AnalysisResults *results,
+                       const TraceOptions *trace, FragilityMatrix *matrix,
+                       int materialize) {
+    int off = filter->kernel_offset;
+    int eff = filter->kernel_eff_len;
+    int warmup = filter->fir_warmup;
+    float hp_b_top = filter->hp_b * top->acc_scale;
+    float hp_b_base = filter->hp_b * base->acc_scale;
+
+    StaLtaScan scan;
+    sta_lta_init(&scan, trigger, filter);
+
+    // Storia: il FIR legge fino a warmup campioni HP indietro, lo STA/LTA
+    // lta_len uscite FIR (lta_len >= eff: nessun indice negativo sotto)
+    TileWindow hp_top, hp_base, fir;
+    int ok = window_init(&hp_top, warmup, 0);
+    ok = window_init(&hp_base, warmup, 0) && ok;
+    ok = window_init(&fir, scan.lta_len, warmup - scan.lta_len) && ok;
+    if (!ok) {
+        free(hp_top.buf);
+        free(hp_base.buf);
+        free(fir.buf);
+        printf("❌ ERRORE: Memoria insufficiente per la pipeline fusa\n");
+        return 0;
+    }
+
+    int triggered = 0, primed = 0, done = 0;
+    int next_i = 0;           // Prossimo campione dell'analisi post-trigger
+    DriftMonitor mon;
+
+    // Primo blocco fino al warm-up, poi blocchi allineati a quelli del FIR
+    // a stadi (stessa suddivisione dei kernel SIMD, risultato identico)
+    int a = 0;
+    int b = (warmup < n) ? warmup : n;
+    while (a < n && !done) {
+        window_advance(&hp_top, a);
+        window_advance(&hp_base, a);
+        highpass_tile(top->acc, &hp_top, a, b, filter->hp_a, hp_b_top);
+        highpass_tile(base->acc, &hp_base, a, b, filter->hp_a, hp_b_base);
+        if (materialize) {
+            memcpy(top->acc_hp + a, window_at(&hp_top, a), (b - a) * sizeof(float));
+            memcpy(base->acc_hp + a, window_at(&hp_base, a), (b - a) * sizeof(float));
+        }
+
+        if (!triggered && a >= warmup) {
+            // acc_fir[i] = sum_k acc_hp[i-off-k] * kernel[off+k], come
+            // apply_gaussian_smoothing con start = eff sul blocco
+            window_advance(&fir, a);
+            fir_simd_range(window_at(&hp_top, a - warmup),
+                           window_at(&fir, a) - eff, eff, eff + (b - a),
+                           filter->kernel + off, eff);
+            if (materialize) {
+                memcpy(top->acc_fir + a, window_at(&fir, a), (b - a) * sizeof(float));
+            }
+
+            if (!primed && b > scan.start_idx) {
+                sta_lta_prime(&scan, fir.buf, fir.origin);
+                primed = 1;
+            }
+            if (primed) {
+                int from = (a > scan.start_idx) ? a : scan.start_idx;
+                triggered = sta_lta_scan(&scan, fir.buf, fir.origin, from, b,
+                                         trigger);
+            }
+            if (triggered) {
+                int t = trigger->trigger_idx;
+                report_trigger(trigger, filter);
+                drift_monitor_init(&mon, t, n, filter, ptm_len_s,
+                                   building_height, threshold, results, trace,
+                                   matrix);
+                if (materialize) {
+                    top->vel_unf[t] = top->vel_filt[t] = top->disp[t] = 0.0f;
+                    base->vel_unf[t] = base->vel_filt[t] = base->disp[t] = 0.0f;
+                }
+                next_i = t + 1;
+            }
+        }
+
+        if (triggered) {
+            int stop = (b < mon.end) ? b : mon.end;
+            for (int i = next_i; i < stop && !done; i++) {
+                int tail = mon.tail;
+                done = drift_monitor_step(&mon, i,
+                                          *window_at(&hp_top, i - 1),
+                                          *window_at(&hp_top, i),
+                                          *window_at(&hp_base, i - 1),
+                                          *window_at(&hp_base, i));
+                if (materialize && !tail) {
+                    top->vel_unf[i] = mon.top_vel_unf;
+                    top->vel_filt[i] = mon.top_vel_filt;
+                    top->disp[i] = mon.top_disp;
+                    base->vel_unf[i] = mon.base_vel_unf;
+                    base->vel_filt[i] = mon.base_vel_filt;
+                    base->disp[i] = mon.base_disp;
+                }
+            }
+            next_i = stop;
+            if (stop >= mon.end) done = 1;
+        }
+
+        a = b;
+        b = (a + FIR_DIRECT_CHUNK < n) ? a + FIR_DIRECT_CHUNK : n;
+    }
+
+    if (triggered) {
+        drift_monitor_close(&mon);
+    } else {
+        LOG_INFO("✗ NESSUN TRIGGER\n");
+    }
+
+    free(hp_top.buf);
+    free(hp_base.buf);
+    free(fir.buf);
+    return triggered;
+}
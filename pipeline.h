@@ -0,0 +1,26 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "types.h"
+#include "trace.h"
+#include "drift_analysis.h"
+
+// Vero se la pipeline fusa riproduce esattamente quella a stadi
+// (kernel esatto con convoluzione diretta e HP seriale; con FFT, IIR o scan
+// parallela dell'HP si usa quella a stadi)
+int fused_pipeline_supported(FilterConfig *filter, int n);
+
+// HP -> FIR -> STA/LTA -> drift/allarme in un solo passaggio a blocchi di
+// FIR_DIRECT_CHUNK campioni; tra i blocchi passa solo lo stato dei filtri.
+// Ritorna 1 se c'è trigger (results valido), 0 altrimenti. Con materialize
+// scrive anche acc_hp, vel_unf, vel_filt, disp e acc_fir TOP (fino al
+// trigger) nei SignalData, come servono al CSV dei risultati. Con matrix
+// valuta anche tutte le soglie di fragilità nello stesso passaggio
+int run_fused_pipeline(SignalData *top, SignalData *base, int n,
+                       FilterConfig *filter, TriggerParams *trigger,
+                       float ptm_len_s, float building_height,
+                       AlarmThreshold *threshold, AnalysisResults *results,
+                       const TraceOptions *trace, FragilityMatrix *matrix,
+                       int materialize);
+
+#endif
@@ -0,0 +1,179 @@
+#include "recursive_gaussian.h"
+#include <stdlib.h>
+#include <math.h>
+
+// Approssimazione di Deriche (4° ordine) di exp(-x²/2σ²), x >= 0:
+// somma di due termini e^(-b x/σ) (a cos(w x/σ) + c sin(w x/σ))
+static const double DERICHE_A[2] = {  1.6800,  -0.6803 };
+static const double DERICHE_C[2] = {  3.7350,  -0.2598 };
+static const double DERICHE_B[2] = {  1.7830,   1.7230 };
+static const double DERICHE_W[2] = {  0.6318,   1.9970 };
+
+// Risposta all'impulso (ritardo j dal punto di ancoraggio)
+static void impulse_response(const RecursiveGaussian *rg, double *h, int len) {
+    double ya[2] = {0.0, 0.0}, yb[2] = {0.0, 0.0};
+    double x1 = 0.0;
+
+    for (int j = 0; j < len; j++) {
+        double x0 = (j == 0) ? 1.0 : 0.0;
+        double sum = 0.0;
+        for (int s = 0; s < 2; s++) {
+            double y = rg->b0[s] * x0 + rg->b1[s] * x1 - rg->a1[s] * ya[s] - rg->a2[s] * yb[s];
+            yb[s] = ya[s];
+            ya[s] = y;
+            sum += y;
+        }
+        h[j] = rg->gain * sum;
+        x1 = x0;
+    }
+}
+
+void init_recursive_gaussian(RecursiveGaussian *rg, const float *kernel, int len) {
+    // Stessa larghezza di create_gaussian_kernel: exp(-(j/(0.05 len))²)
+    double sigma = 0.050 * len / sqrt(2.0);
+    double dc = 0.0;
+
+    for (int s = 0; s < 2; s++) {
+        double rho = exp(-DERICHE_B[s] / sigma);
+        double theta = DERICHE_W[s] / sigma;
+
+        rg->b0[s] = (float)DERICHE_A[s];
+        rg->b1[s] = (float)(rho * (DERICHE_C[s] * sin(theta) - DERICHE_A[s] * cos(theta)));
+        rg->a1[s] = (float)(-2.0 * rho * cos(theta));
+        rg->a2[s] = (float)(rho * rho);
+
+        dc += ((double)rg->b0[s] + rg->b1[s]) / (1.0 + rg->a1[s] + rg->a2[s]);
+    }
+
+    rg->gain = (float)(1.0 / dc);
+    rg->delay = len - 1;
+    rg->settle = (int)ceil(6.0 * sigma);
+    if (rg->settle < 4) rg->settle = 4;
+
+    // Errore rispetto al kernel esatto: norma L1 della differenza delle
+    // risposte, sia sul record intero sia troncata a settle (streaming)
+    int h_len = len + rg->settle;
+    double *h = (double*)malloc(h_len * sizeof(double));
+    if (!h) {
+        rg->error_bound = -1.0f;
+        return;
+    }
+    impulse_response(rg, h, h_len);
+
+    double err_full = 0.0, err_trunc = 0.0;
+    for (int j = 0; j < h_len; j++) {
+        double exact = (j < len) ? kernel[len - 1 - j] : 0.0;
+        double d = fabs(h[j] - exact);
+        err_full += d;
+        err_trunc += (j <= rg->settle) ? d : fabs(exact);
+    }
+    free(h);
+
+    rg->error_bound = (float)(err_full > err_trunc ? err_full : err_trunc);
+}
+
+void apply_recursive_gaussian(const RecursiveGaussian *rg, float *input,
+                              float *output, int n, int first) {
+    float ya[2] = {0.0f, 0.0f}, yb[2] = {0.0f, 0.0f};
+    float x1 = 0.0f;
+
+    // Passata anticausale: y[p] pesa x[p], x[p+1], ... e va in uscita a p + delay
+    for (int p = n - 1; p >= 0; p--) {
+        float x0 = input[p];
+        for (int s = 0; s < 2; s++) {
+            float y = rg->b0[s] * x0 + rg->b1[s] * x1 - rg->a1[s] * ya[s] - rg->a2[s] * yb[s];
+            yb[s] = ya[s];
+            ya[s] = y;
+        }
+        x1 = x0;
+
+        int i = p + rg->delay;
+        if (i < n && i >= first) {
+            output[i] = rg->gain * (ya[0] + ya[1]);
+        }
+    }
+}
+
+int rg_stream_init(RecursiveGaussianStream *st, const RecursiveGaussian *rg) {
+    st->rg = rg;
+
+    // Un blocco deve essere pronto prima che il suo ritardo scada, anche
+    // con la passata distribuita sui block campioni successivi
+    st->block = rg->settle;
+    if (2 * st->block + rg->settle > rg->delay + 1) {
+        st->block = (rg->delay + 1 - rg->settle) / 2;
+    }
+    if (st->block < 1) return 0;
+
+    int span = st->block + rg->settle;
+    st->in_cap = span + st->block;
+    st->in_buf = (float*)calloc(st->in_cap, sizeof(float));
+    st->ring_len = rg->delay + 1;
+    st->out_ring = (float*)calloc(st->ring_len, sizeof(float));
+    st->in_head = 0;
+    st->in_count = 0;
+    st->pass_q = -1;
+    st->pass_steps = (span + st->block - 1) / st->block;
+
+    if (!st->in_buf || !st->out_ring) {
+        rg_stream_free(st);
+        return 0;
+    }
+    return 1;
+}
+
+float rg_stream_push(RecursiveGaussianStream *st, float x, long i) {
+    const RecursiveGaussian *rg = st->rg;
+    int span = st->block + rg->settle;
+
+    int tail = st->in_head + st->in_count++;
+    st->in_buf[tail < st->in_cap ? tail : tail - st->in_cap] = x;
+
+    if (st->pass_q < 0 && st->in_count == span) {
+        // Passata anticausale da stato nullo: i primi 'block' valori sono assestati
+        st->pass_q = span - 1;
+        st->pass_p0 = i - (span - 1);
+        st->ya[0] = st->ya[1] = st->yb[0] = st->yb[1] = 0.0f;
+        st->x1 = 0.0f;
+    }
+
+    if (st->pass_q >= 0) {
+        // Pochi passi per campione: le uscite del blocco servono solo da
+        // pass_p0 + delay, oltre la fine della passata
+        int q_end = st->pass_q - st->pass_steps;
+        if (q_end < -1) q_end = -1;
+        for (int q = st->pass_q; q > q_end; q--) {
+            int pos = st->in_head + q;
+            float x0 = st->in_buf[pos < st->in_cap ? pos : pos - st->in_cap];
+            for (int s = 0; s < 2; s++) {
+                float y = rg->b0[s] * x0 + rg->b1[s] * st->x1 - rg->a1[s] * st->ya[s] - rg->a2[s] * st->yb[s];
+                st->yb[s] = st->ya[s];
+                st->ya[s] = y;
+            }
+            st->x1 = x0;
+
+            if (q < st->block) {
+                long out_idx = st->pass_p0 + q + rg->delay;
+                st->out_ring[out_idx % st->ring_len] = rg->gain * (st->ya[0] + st->ya[1]);
+            }
+        }
+        st->pass_q = q_end;
+
+        if (st->pass_q < 0) {
+            // Passata conclusa: resta l'assestamento più i nuovi ingressi,
+            // basta avanzare l'inizio del ring (nessuna copia a fine blocco)
+            st->in_head += st->block;
+            if (st->in_head >= st->in_cap) st->in_head -= st->in_cap;
+            st->in_count -= st->block;
+        }
+    }
+
+    return st->out_ring[i % st->ring_len];
+}
+
+void rg_stream_free(RecursiveGaussianStream *st) {
+    free(st->in_buf);
+    free(st->out_ring);
+    st->in_buf = NULL;
+    st->out_ring = NULL;
+}
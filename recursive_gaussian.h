@@ -0,0 +1,40 @@
+#ifndef RECURSIVE_GAUSSIAN_H
+#define RECURSIVE_GAUSSIAN_H
+
+#include "types.h"
+
+// Stato per uso campione per campione (blocchi anticausali sovrapposti).
+// La passata di un blocco si distribuisce sui block campioni successivi:
+// costo per campione costante, non solo in media
+typedef struct {
+    const RecursiveGaussian *rg;
+    int block;            // Uscite assestate prodotte per blocco
+    float *in_buf;        // Ring: blocco in passata (block + settle) e nuovi ingressi
+    int in_cap;           // Capacità del ring (span + block)
+    int in_head;          // Posizione del primo ingresso nel ring
+    int in_count;
+    float *out_ring;      // Uscite già calcolate, indicizzate per campione
+    int ring_len;
+    int pass_q;           // Prossimo ingresso della passata (-1 = nessuna)
+    int pass_steps;       // Passi di passata per campione
+    long pass_p0;         // Indice del primo ingresso del blocco in passata
+    float ya[2], yb[2], x1;  // Stato della passata in corso
+} RecursiveGaussianStream;
+
+// Calcola coefficienti per il kernel di init_filter_config e stima errore
+void init_recursive_gaussian(RecursiveGaussian *rg, const float *kernel, int len);
+
+// Applica su un record intero (uscite per i >= first, come apply_fir_filter)
+void apply_recursive_gaussian(const RecursiveGaussian *rg, float *input,
+                              float *output, int n, int first);
+
+// Inizializza stato streaming
+int rg_stream_init(RecursiveGaussianStream *st, const RecursiveGaussian *rg);
+
+// Elabora il campione i, ritorna l'uscita filtrata per lo stesso indice
+float rg_stream_push(RecursiveGaussianStream *st, float x, long i);
+
+// Libera stato streaming
+void rg_stream_free(RecursiveGaussianStream *st);
+
+#endif
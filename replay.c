@@ -0,0 +1,158 @@
+#include "replay.h"
+#include "stream.h"
+#include "trigger.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+const double replay_percentiles[REPLAY_NPCT] = {50.0, 90.0, 99.0, 99.9, 100.0};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Attende l'istante assoluto t (ns, CLOCK_MONOTONIC): sleep fino a
+// REPLAY_SPIN_NS dalla scadenza, poi attesa attiva
+static void wait_until(double t) {
+    double remaining = t - now_ns();
+    if (remaining > REPLAY_SPIN_NS) {
+        double target = t - REPLAY_SPIN_NS;
+        struct timespec ts;
+        ts.tv_sec = (time_t)(target / 1e9);
+        ts.tv_nsec = (long)(target - ts.tv_sec * 1e9);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {}
+    }
+    while (now_ns() < t) {}
+}
+
+static int compare_float(const void *a, const void *b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+// Percentili (rango più vicino) di v[0..n), ordinato sul posto
+static void percentiles(float *v, long n, double *out) {
+    if (n <= 0) {
+        for (int p = 0; p < REPLAY_NPCT; p++) out[p] = 0.0;
+        return;
+    }
+    qsort(v, n, sizeof(float), compare_float);
+    for (int p = 0; p < REPLAY_NPCT; p++) {
+        long rank = (long)ceil(replay_percentiles[p] / 100.0 * n);
+        if (rank < 1) rank = 1;
+        out[p] = v[rank - 1];
+    }
+}
+
+int run_replay(const float *acc_top, const float *acc_base, int n,
+               float scale_top, float scale_base, FilterConfig *filter,
+               float sta_s, float lta_s, float ptm_len_s,
+               float building_height, AlarmThreshold *threshold,
+               const ReplayOptions *opt, ReplayStats *stats) {
+    int packet = opt->packet > 0 ? opt->packet : 1;
+    int repeat = opt->repeat > 0 ? opt->repeat : 1;
+    long total = (long)n * repeat;
+    
+    memset(stats, 0, sizeof(*stats));
+    stats->budget_ns = filter->dt * 1e9 / opt->speed;
+    stats->trigger_idx = stats->alarm_idx = -1;
+    
+    float *proc = (float*)malloc((total > 0 ? total : 1) * sizeof(float));
+    float *latency = (float*)malloc(repeat * sizeof(float));
+    float *reaction = (float*)malloc(repeat * sizeof(float));
+    if (!proc || !latency || !reaction) {
+        free(proc);
+        free(latency);
+        free(reaction);
+        return 0;
+    }
+    
+    double budget = stats->budget_ns;
+    double wall_start = now_ns();
+    
+    for (int r = 0; r < repeat; r++) {
+        // Motore nuovo a ogni ripetizione: stesso stato di un avvio a freddo
+        TriggerParams trigger;
+        init_trigger_params(&trigger, sta_s, lta_s);
+        StreamEngine eng;
+        if (!stream_init(&eng, filter, &trigger, threshold, ptm_len_s,
+                         building_height)) {
+            free(proc);
+            free(latency);
+            free(reaction);
+            return 0;
+        }
+        stream_set_input_scale(&eng, scale_top, scale_base);
+        if (opt->live) stream_set_live(&eng, opt->live);
+        
+        double t0 = now_ns();
+        double trigger_wall = 0.0;
+        int alarm_seen = 0;
+        AnalysisResults last = eng.results;
+        
+        for (int i0 = 0; i0 < n; i0 += packet) {
+            int count = (n - i0 < packet) ? n - i0 : packet;
+            // Consegna con l'ultimo campione acquisito; il pacchetto deve
+            // essere elaborato prima che arrivi il successivo
+            double release = t0 + (i0 + count) * budget;
+            double deadline = release + count * budget;
+            wait_until(release);
+            
+            for (int j = 0; j < count; j++) {
+                int i = i0 + j;
+                StreamEvent ev;
+                double start = now_ns();
+                int events = stream_push(&eng, acc_top[i], acc_base[i], &ev);
+                double end = now_ns();
+                
+                proc[stats->samples++] = (float)(end - start);
+                if (end > deadline) {
+                    stats->misses++;
+                    if (end - deadline > stats->late_max_ns) {
+                        stats->late_max_ns = end - deadline;
+                    }
+                }
+                
+                if (events & STREAM_EVENT_TRIGGER) {
+                    stats->n_triggers++;
+                    // L'allarme cade nella finestra dell'ultimo trigger
+                    if (!alarm_seen) {
+                        trigger_wall = end;
+                        if (r == repeat - 1) stats->trigger_idx = (int)ev.sample_idx;
+                    }
+                }
+                if ((events & STREAM_EVENT_ALARM) && !alarm_seen) {
+                    // Prima allarme della ripetizione: latenza dal trigger
+                    // e dall'acquisizione del campione che l'ha generato
+                    alarm_seen = 1;
+                    double acquired = t0 + (i + 1) * budget;
+                    latency[stats->n_alarms] = (float)((end - trigger_wall) / 1e6);
+                    reaction[stats->n_alarms] = (float)((end - acquired) / 1e3);
+                    stats->n_alarms++;
+                    if (r == repeat - 1) stats->alarm_idx = (int)ev.sample_idx;
+                }
+                if (events & (STREAM_EVENT_ALARM | STREAM_EVENT_PTM_END)) {
+                    last = eng.results;
+                }
+            }
+        }
+        
+        // Come run_stream_mode: finestra ancora aperta a fine record
+        if (eng.state == STREAM_MONITORING) last = eng.results;
+        if (r == repeat - 1) stats->results = last;
+        stream_free(&eng);
+    }
+    
+    stats->wall_s = (now_ns() - wall_start) / 1e9;
+    percentiles(proc, stats->samples, stats->proc_ns);
+    percentiles(latency, stats->n_alarms, stats->latency_ms);
+    percentiles(reaction, stats->n_alarms, stats->reaction_us);
+    
+    free(proc);
+    free(latency);
+    free(reaction);
+    return 1;
+}
@@ -0,0 +1,47 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "types.h"
+#include "live.h"
+
+#define REPLAY_NPCT 5             // Percentili riportati: 50, 90, 99, 99.9, max
+#define REPLAY_SPIN_NS 50000.0    // Sotto questa attesa si gira invece di dormire
+
+// Opzioni del replay in tempo reale
+typedef struct {
+    double speed;             // Velocità rispetto al tempo reale (1 = 1/fs)
+    int packet;               // Campioni consegnati insieme dall'acquisitore
+    int repeat;               // Ripetizioni del record (campioni di latenza)
+    LivePublisher *live;      // Stato live in memoria condivisa (NULL = no)
+} ReplayOptions;
+
+// Misure del replay. Il campione i è acquisito a t0 + (i+1) * budget; un
+// pacchetto è consegnato con il suo ultimo campione e va elaborato prima
+// che arrivi il successivo (scadenza = consegna + packet * budget)
+typedef struct {
+    double budget_ns;                     // Periodo scalato: 1/fs / speed
+    long samples;
+    long misses;                          // Campioni completati oltre scadenza
+    double late_max_ns;                   // Ritardo massimo oltre scadenza
+    double proc_ns[REPLAY_NPCT];          // Tempo di elaborazione per campione
+    int n_triggers;
+    int n_alarms;
+    double latency_ms[REPLAY_NPCT];       // Trigger -> allarme (orologio)
+    double reaction_us[REPLAY_NPCT];      // Acquisizione -> allarme emesso
+    double wall_s;                        // Durata complessiva del replay
+    int trigger_idx, alarm_idx;           // Indici dell'ultima ripetizione
+    AnalysisResults results;              // Risultati dell'ultima ripetizione
+} ReplayStats;
+
+// Percentili corrispondenti alle colonne di ReplayStats
+extern const double replay_percentiles[REPLAY_NPCT];
+
+// Spinge i campioni nel motore streaming al ritmo di fs * speed, misurando
+// ogni campione contro la propria scadenza. Ritorna 0 se manca memoria
+int run_replay(const float *acc_top, const float *acc_base, int n,
+               float scale_top, float scale_base, FilterConfig *filter,
+               float sta_s, float lta_s, float ptm_len_s,
+               float building_height, AlarmThreshold *threshold,
+               const ReplayOptions *opt, ReplayStats *stats);
+
+#endif
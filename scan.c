@@ -0,0 +1,104 @@
+#include "scan.h"
+#include "config.h"
+#include <stdlib.h>
+#include <math.h>
+#include <omp.h>
+
+static int scan_enabled = 1;
+
+void set_parallel_scan(int enable) {
+    scan_enabled = enable;
+}
+
+// Blocchi per la scan: uno per thread, almeno SCAN_MIN_BLOCK campioni l'uno
+int scan_blocks(int n) {
+    int blocks = n / SCAN_MIN_BLOCK;
+    int threads = omp_get_max_threads();
+    return blocks < threads ? blocks : threads;
+}
+
+int scan_parallel_enabled(int n) {
+    return scan_enabled && n >= SCAN_PARALLEL_MIN && scan_blocks(n) > 1;
+}
+
+// Ricorrenza su [s, e) con y[s-1] = 0: stesse operazioni del loop seriale
+static void scan_local(const float *x, float *y, int s, int e,
+                       float a, float b) {
+    float prev = 0.0f;
+    if (s == 0) {
+        y[0] = 0.0f;
+        s = 1;
+    }
+    for (int i = s; i < e; i++) {
+        prev = x[i] * b - x[i-1] * b + a * prev;
+        y[i] = prev;
+    }
+}
+
+// Aggiunge il contributo dello stato di ingresso: y[i] += a^(i-s+1) * carry
+static void scan_fixup(float *y, int s, int e, float a, double carry) {
+    double p = a;
+    for (int i = s; i < e && p > SCAN_DECAY_EPS; i++) {
+        y[i] += (float)(p * carry);
+        p *= a;
+    }
+}
+
+// Inizio del blocco t di nb su n campioni
+static int block_start(int n, int t, int nb) {
+    return (int)((long)n * t / nb);
+}
+
+static void scan_parallel(const float *x, float *y, int n,
+                          float a, float b) {
+    int nb = scan_blocks(n);
+    double carry[nb];
+    
+    // Ogni blocco da stato nullo; dentro il grafo a task i blocchi
+    // diventano task della squadra già attiva
+    if (omp_in_parallel()) {
+        #pragma omp taskloop grainsize(1)
+        for (int t = 0; t < nb; t++) {
+            scan_local(x, y, block_start(n, t, nb),
+                       block_start(n, t + 1, nb), a, b);
+        }
+    } else {
+        #pragma omp parallel for schedule(static, 1)
+        for (int t = 0; t < nb; t++) {
+            scan_local(x, y, block_start(n, t, nb),
+                       block_start(n, t + 1, nb), a, b);
+        }
+    }
+    
+    // Composizione affine degli stati: y_in[t] = y[e-1] + a^len y_in[t-1]
+    carry[0] = 0.0;
+    for (int t = 1; t < nb; t++) {
+        int ps = block_start(n, t - 1, nb), pe = block_start(n, t, nb);
+        double decay = pow((double)a, pe - ps);
+        carry[t] = (double)y[pe - 1] + decay * carry[t-1];
+    }
+    
+    if (omp_in_parallel()) {
+        #pragma omp taskloop grainsize(1)
+        for (int t = 1; t < nb; t++) {
+            scan_fixup(y, block_start(n, t, nb), block_start(n, t + 1, nb),
+                       a, carry[t]);
+        }
+    } else {
+        #pragma omp parallel for schedule(static, 1)
+        for (int t = 1; t < nb; t++) {
+            scan_fixup(y, block_start(n, t, nb), block_start(n, t + 1, nb),
+                       a, carry[t]);
+        }
+    }
+}
+
+void scan_highpass(const float *input, float *output, int n,
+                   float a, float b) {
+    if (n <= 0) return;
+    if (scan_parallel_enabled(n)) {
+        scan_parallel(input, output, n, a, b);
+    } else {
+        scan_local(input, output, 0, n, a, b);
+    }
+}
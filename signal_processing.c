@@ -3,70 +3,130 @@
 #include <string.h>
 #include <math.h>
 #include <omp.h>
+#include <sys/mman.h>
+
+#define ARENA_ARRAYS 6                  // acc, acc_hp, acc_fir, vel_unf, vel_filt, disp
+#define ARENA_ALIGN_FLOATS 16           // Ogni array allineato a 64 byte
+#define HUGE_PAGE_SIZE (2u << 20)
+
+static int use_huge_pages = 0;
+
+void set_signal_huge_pages(int enable) {
+    use_huge_pages = enable;
+}
+
+// Memoria anonima: già azzerata dal kernel, pagine allocate al primo uso
+static void* arena_map(size_t *bytes, int *huge) {
+    void *p = MAP_FAILED;
+    *huge = 0;
+    
+    if (use_huge_pages && *bytes >= HUGE_PAGE_SIZE) {
+        size_t rounded = (*bytes + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+        p = mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (p != MAP_FAILED) {
+            *bytes = rounded;
+            *huge = 1;
+            return p;
+        }
+    }
+    
+    p = mmap(NULL, *bytes, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+    // Senza pagine riservate: huge page trasparenti se disponibili
+    if (use_huge_pages) madvise(p, *bytes, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+// Ridistribuisce l'arena tra gli array (capacity campioni ciascuno)
+static void arena_layout(SignalData *data, float *base, int capacity) {
+    float *slot[ARENA_ARRAYS];
+    for (int k = 0; k < ARENA_ARRAYS; k++) slot[k] = base + (size_t)k * capacity;
+    
+    if (!data->acc_mapped) data->acc = slot[0];
+    data->acc_hp = slot[1];
+    data->acc_fir = slot[2];
+    data->vel_unf = slot[3];
+    data->vel_filt = slot[4];
+    data->disp = slot[5];
+}
 
 SignalData* create_signal_data(int n_samples) {
-    SignalData *data = (SignalData*)malloc(sizeof(SignalData));
+    SignalData *data = (SignalData*)calloc(1, sizeof(SignalData));
+    if (!data) return NULL;
     
-    data->acc = (float*)calloc(n_samples, sizeof(float));
-    data->acc_hp = (float*)calloc(n_samples, sizeof(float));
-    data->acc_fir = (float*)calloc(n_samples, sizeof(float));
-    data->vel_unf = (float*)calloc(n_samples, sizeof(float));
-    data->vel_filt = (float*)calloc(n_samples, sizeof(float));
-    data->disp = (float*)calloc(n_samples, sizeof(float));
+    data->acc_scale = 1.0f;
+    if (!reserve_signal_data(data, n_samples)) {
+        free(data);
+        return NULL;
+    }
     data->n_samples = n_samples;
     
     return data;
 }
 
-void free_signal_data(SignalData *data) {
-    if (data) {
-        free(data->acc);
-        free(data->acc_hp);
-        free(data->acc_fir);
-        free(data->vel_unf);
-        free(data->vel_filt);
-        free(data->disp);
-        free(data);
+int reserve_signal_data(SignalData *data, int n_samples) {
+    if (n_samples <= data->capacity && data->arena) return 1;
+    
+    int capacity = (n_samples + ARENA_ALIGN_FLOATS - 1) & ~(ARENA_ALIGN_FLOATS - 1);
+    if (capacity == 0) capacity = ARENA_ALIGN_FLOATS;
+    size_t bytes = (size_t)ARENA_ARRAYS * capacity * sizeof(float);
+    int huge;
+    float *base = (float*)arena_map(&bytes, &huge);
+    if (!base) return 0;
+    
+    // Crescita (streaming): conserva i campioni già presenti
+    if (data->arena) {
+        float *old[ARENA_ARRAYS] = {data->acc, data->acc_hp, data->acc_fir,
+                                    data->vel_unf, data->vel_filt, data->disp};
+        for (int k = data->acc_mapped ? 1 : 0; k < ARENA_ARRAYS; k++) {
+            memcpy(base + (size_t)k * capacity, old[k],
+                   (size_t)data->capacity * sizeof(float));
+        }
+        munmap(data->arena, data->arena_bytes);
     }
+    
+    data->arena = base;
+    data->arena_bytes = bytes;
+    data->arena_huge = huge;
+    data->capacity = capacity;
+    arena_layout(data, base, capacity);
+    return 1;
 }
 
-void init_signal_arrays(SignalData *data) {
-    #pragma omp parallel for
-    for (int i = 0; i < data->n_samples; i++) {
-        data->acc_hp[i] = 0.0f;
-        data->acc_fir[i] = 0.0f;
-        data->vel_unf[i] = 0.0f;
-        data->vel_filt[i] = 0.0f;
-        data->disp[i] = 0.0f;
-    }
+void attach_external_acc(SignalData *data, const float *acc, float scale) {
+    data->acc = (float*)acc;      // Solo lettura: mai scritto dalla pipeline
+    data->acc_scale = scale;
+    data->acc_mapped = 1;
 }
 
-void integrate_to_velocity(float *acc, float *vel_unf, float *vel_filt,
-                           int start, int end, float dt, 
-                           float hp_a, float hp_b) {
-    vel_unf[start] = 0.0f;
-    vel_filt[start] = 0.0f;
-    
-    for (int i = start + 1; i < end; i++) {
-        // Integrazione trapezoidale
-        vel_unf[i] = vel_unf[i-1] + (acc[i-1] + acc[i]) * 0.5f * dt;
-        
-        // High-pass sulla velocità
-        vel_filt[i] = vel_unf[i] * hp_b - vel_unf[i-1] * hp_b + 
-                      hp_a * vel_filt[i-1];
-    }
+void detach_external_acc(SignalData *data) {
+    data->acc = (float*)data->arena;
+    data->acc_scale = 1.0f;
+    data->acc_mapped = 0;
 }
 
-void integrate_to_displacement(float *vel, float *disp,
-                               int start, int end, float dt) {
-    disp[start] = 0.0f;
-    
-    for (int i = start + 1; i < end; i++) {
-        // Integrazione trapezoidale
-        disp[i] = disp[i-1] + (vel[i-1] + vel[i]) * 0.5f * dt;
+void free_signal_data(SignalData *data) {
+    if (data) {
+        if (data->arena) munmap(data->arena, data->arena_bytes);
+        free(data);
     }
 }
 
+void init_signal_arrays(SignalData *data) {
+    // acc, acc_hp e acc_fir sono riscritti per intero da lettura e filtri:
+    // solo gli integratori sono scritti a tratti (dal trigger in poi)
+    size_t bytes = (size_t)data->n_samples * sizeof(float);
+    memset(data->vel_unf, 0, bytes);
+    memset(data->vel_filt, 0, bytes);
+    memset(data->disp, 0, bytes);
+}
+
 float calculate_pga(float *data, int n) {
     float pga = 0.0f;
     for (int i = 0; i < n; i++) {
@@ -3,23 +3,27 @@
 
 #include "types.h"
 
-// Alloca dati segnale
+// Alloca dati segnale: un'unica arena allineata, azzerata dal kernel
 SignalData* create_signal_data(int n_samples);
 
+// Garantisce spazio per n_samples per array (cresce conservando i dati)
+int reserve_signal_data(SignalData *data, int n_samples);
+
+// Arena su huge page (MAP_HUGETLB, altrimenti THP) per le nuove allocazioni
+void set_signal_huge_pages(int enable);
+
 // Libera dati segnale
 void free_signal_data(SignalData *data);
 
-// Inizializza array a zero
-void init_signal_arrays(SignalData *data);
+// Usa campioni esterni (es. file mappato) come acc, senza copia;
+// scale è il fattore verso m/s² applicato a valle nel filtro HP
+void attach_external_acc(SignalData *data, const float *acc, float scale);
 
-// Integra accelerazione per ottenere velocità
-void integrate_to_velocity(float *acc, float *vel_unf, float *vel_filt,
-                           int start, int end, float dt, 
-                           float hp_a, float hp_b);
+// Torna al buffer acc proprio (riuso della struttura per un altro record)
+void detach_external_acc(SignalData *data);
 
-// Integra velocità per ottenere spostamento
-void integrate_to_displacement(float *vel, float *disp,
-                               int start, int end, float dt);
+// Azzera gli array scritti solo in parte (integratori) per il riuso
+void init_signal_arrays(SignalData *data);
 
 // Calcola PGA
 float calculate_pga(float *data, int n);
@@ -0,0 +1,130 @@
+#include "std_rates.h"
+#include "config.h"
+#include <stddef.h>
+
+// Kernel gaussiani normalizzati generati con create_gaussian_kernel (somma
+// in ordine seriale); i taps iniziali sono nulli in float
+static const float kernel_100[200] = {
+    [99] =
+    4.20389539e-45f, 2.94272678e-44f, 2.08793471e-43f, 1.4643569e-42f, 1.00935528e-41f,
+    6.81619599e-41f, 4.51191481e-40f, 2.9274316e-39f, 1.86180466e-38f, 1.16062131e-37f,
+    7.0919518e-37f, 4.24772747e-36f, 2.493751e-35f, 1.43506554e-34f, 8.09461206e-34f,
+    4.4755096e-33f, 2.42551828e-32f, 1.28846382e-31f, 6.70901552e-31f, 3.42416163e-30f,
+    1.71305766e-29f, 8.40040568e-29f, 4.03776268e-28f, 1.90239315e-27f, 8.78557626e-27f,
+    3.9769874e-26f, 1.76462354e-25f, 7.67477203e-25f, 3.27185819e-24f, 1.36720639e-23f,
+    5.60001502e-23f, 2.24832098e-22f, 8.84792147e-22f, 3.41304051e-21f, 1.29048286e-20f,
+    4.78274182e-20f, 1.73746302e-19f, 6.18685293e-19f, 2.15943192e-18f, 7.38790905e-18f,
+    2.47752157e-17f, 8.14380423e-17f, 2.62392278e-16f, 8.28689866e-16f, 2.56533711e-15f,
+    7.78414215e-15f, 2.31521311e-14f, 6.74972299e-14f, 1.92884473e-13f, 5.4028147e-13f,
+    1.4833949e-12f, 3.9921625e-12f, 1.0531096e-11f, 2.7230428e-11f, 6.90156612e-11f,
+    1.7145714e-10f, 4.17520074e-10f, 9.9658215e-10f, 2.3316602e-09f, 5.34722933e-09f,
+    1.20200729e-08f, 2.648496e-08f, 5.72014009e-08f, 1.21095255e-07f, 2.51282785e-07f,
+    5.11106521e-07f, 1.01900059e-06f, 1.99137094e-06f, 3.8145472e-06f, 7.16224213e-06f,
+    1.31816105e-05f, 2.37794538e-05f, 4.20484721e-05f, 7.28805899e-05f, 0.000123819322f,
+    0.000206195095f, 0.000336575496f, 0.000538519002f, 0.000844565686f, 0.00129831606f,
+    0.00195632456f, 0.0028894539f, 0.00418316294f, 0.00593618909f, 0.00825704914f,
+    0.0112578701f, 0.0150453281f, 0.0197088476f, 0.0253066551f, 0.0318509564f,
+    0.0392938294f, 0.047516048f, 0.0563209951f, 0.0654356703f, 0.0745199919f,
+    0.083185032f, 0.0910189226f, 0.0976185426f, 0.102623552f, 0.105748907f,
+    0.106811702f
+};
+
+static const float kernel_128[256] = {
+    [126] =
+    1.40129846e-45f, 2.80259693e-45f, 1.54142831e-44f, 7.00649232e-44f, 3.22298647e-43f,
+    1.47556728e-42f, 6.6631742e-42f, 2.97271456e-41f, 1.31000387e-40f, 5.70294844e-40f,
+    2.45257219e-39f, 1.04194122e-38f, 4.37283594e-38f, 1.81293258e-37f, 7.42503842e-37f,
+    3.00409943e-36f, 1.20068325e-35f, 4.74068578e-35f, 1.84906616e-34f, 7.12462948e-34f,
+    2.71188108e-33f, 1.01971204e-32f, 3.78776488e-32f, 1.38991134e-31f, 5.03836533e-31f,
+    1.80422547e-30f, 6.38249497e-30f, 2.2304306e-29f, 7.69990764e-29f, 2.6259164e-28f,
+    8.84656757e-28f, 2.94419973e-27f, 9.67961913e-27f, 3.14374876e-26f, 1.00863946e-25f,
+    3.19685266e-25f, 1.00093965e-24f, 3.09593393e-24f, 9.45962633e-24f, 2.85532054e-23f,
+    8.51401356e-23f, 2.50791201e-22f, 7.29774794e-22f, 2.0977995e-21f, 5.95713788e-21f,
+    1.6711286e-20f, 4.6310621e-20f, 1.26779775e-19f, 3.4286078e-19f, 9.1597628e-19f,
+    2.41740391e-18f, 6.30249878e-18f, 1.62321043e-17f, 4.12986167e-17f, 1.03799368e-16f,
+    2.57722559e-16f, 6.32133436e-16f, 1.53166437e-15f, 3.6662072e-15f, 8.66899936e-15f,
+    2.02497439e-14f, 4.67270706e-14f, 1.06516331e-13f, 2.39862519e-13f, 5.33589286e-13f,
+    1.1726014e-12f, 2.54561216e-12f, 5.45924547e-12f, 1.15656911e-11f, 2.42052246e-11f,
+    5.00432057e-11f, 1.02206792e-10f, 2.06211506e-10f, 4.11002649e-10f, 8.09235512e-10f,
+    1.57399627e-09f, 3.02434344e-09f, 5.74059689e-09f, 1.07641949e-08f, 1.99390549e-08f,
+    3.64859929e-08f, 6.59547794e-08f, 1.17778221e-07f, 2.07769702e-07f, 3.62074587e-07f,
+    6.23321966e-07f, 1.06004757e-06f, 1.78088885e-06f, 2.9556079e-06f, 4.84568727e-06f,
+    7.84806434e-06f, 1.25564884e-05f, 1.98459747e-05f, 3.09866955e-05f, 4.77943504e-05f,
+    7.28243249e-05f, 0.000109616245f, 0.000162994125f, 0.000239423898f, 0.000347425404f,
+    0.000498028588f, 0.000705253915f, 0.000986586791f, 0.00136340095f, 0.00186127471f,
+    0.00251012831f, 0.00334410486f, 0.00440111244f, 0.00572194299f, 0.00734891417f,
+    0.00932398066f, 0.0116863297f, 0.0144694988f, 0.0176981278f, 0.0213845298f,
+    0.0255252924f, 0.0300981812f, 0.0350597091f, 0.0403436273f, 0.0458606444f,
+    0.0514996052f, 0.0571302548f, 0.0626075938f, 0.0677776337f, 0.0724843666f,
+    0.0765774474f, 0.0799200833f, 0.0823966488f, 0.0839192793f, 0.0844330415f
+};
+
+static const float kernel_200[400] = {
+    [198] =
+    1.40129846e-45f, 1.40129846e-45f, 5.60519386e-45f, 1.54142831e-44f, 4.06376555e-44f,
+    1.06498683e-43f, 2.84463588e-43f, 7.52497275e-43f, 1.98003473e-42f, 5.18480432e-42f,
+    1.35085172e-41f, 3.5015646e-41f, 9.03150873e-41f, 2.31785976e-40f, 5.91876241e-40f,
+    1.50387351e-39f, 3.80208567e-39f, 9.56442254e-39f, 2.39400688e-38f, 5.96231869e-38f,
+    1.47753549e-37f, 3.64326189e-37f, 8.93866453e-37f, 2.18213318e-36f, 5.30041229e-36f,
+    1.28108436e-35f, 3.08086164e-35f, 7.37218744e-35f, 1.75528226e-34f, 4.15834616e-34f,
+    9.80236107e-34f, 2.29914903e-33f, 5.36578531e-33f, 1.24603195e-32f, 2.87902106e-32f,
+    6.61906822e-32f, 1.51417226e-31f, 3.44654074e-31f, 7.8058693e-31f, 1.759053e-30f,
+    3.9443271e-30f, 8.8002826e-30f, 1.95365732e-29f, 4.31543815e-29f, 9.48490104e-29f,
+    2.07427061e-28f, 4.51368357e-28f, 9.77293217e-28f, 2.10544241e-27f, 4.51330705e-27f,
+    9.6265613e-27f, 2.04304929e-26f, 4.31434192e-26f, 9.06518523e-26f, 1.89526606e-25f,
+    3.94266739e-25f, 8.16093173e-25f, 1.68081193e-24f, 3.44447634e-24f, 7.02358284e-24f,
+    1.42501869e-23f, 2.87682773e-23f, 5.77876648e-23f, 1.15500255e-22f, 2.29700544e-22f,
+    4.54533475e-22f, 8.94954796e-22f, 1.75333977e-21f, 3.41787192e-21f, 6.62944023e-21f,
+    1.27944816e-20f, 2.45697974e-20f, 4.69470751e-20f, 8.9256575e-20f, 1.688515e-19f,
+    3.17829649e-19f, 5.95271687e-19f, 1.10933864e-18f, 2.05702468e-18f, 3.79530069e-18f,
+    6.96753751e-18f, 1.27274699e-17f, 2.31331431e-17f, 4.18361716e-17f, 7.52836398e-17f,
+    1.34795592e-16f, 2.40149749e-16f, 4.25712751e-16f, 7.5089222e-16f, 1.31785939e-15f,
+    2.30137264e-15f, 3.99885271e-15f, 6.91373448e-15f, 1.18936623e-14f, 2.03586927e-14f,
+    3.4674527e-14f, 5.87627074e-14f, 9.9088191e-14f, 1.66252293e-13f, 2.77552205e-13f,
+    4.61049276e-13f, 7.62046351e-13f, 1.2532667e-12f, 2.05084495e-12f, 3.33927287e-12f,
+    5.41001141e-12f, 8.72115921e-12f, 1.39887563e-11f, 2.23259744e-11f, 3.54545733e-11f,
+    5.60223569e-11f, 8.80805845e-11f, 1.37793235e-10f, 2.14487497e-10f, 3.32205374e-10f,
+    5.11962028e-10f, 7.85053689e-10f, 1.1978154e-09f, 1.81847282e-09f, 2.7469671e-09f,
+    4.12883283e-09f, 6.1749259e-09f, 9.18890652e-09f, 1.36057956e-08f, 2.00453574e-08f,
+    2.93853795e-08f, 4.2862478e-08f, 6.2208791e-08f, 8.98369734e-08f, 1.29088448e-07f,
+    1.84564115e-07f, 2.62564527e-07f, 3.71666431e-07f, 5.23478775e-07f, 7.33624972e-07f,
+    1.02300282e-06f, 1.41941041e-06f, 1.95960092e-06f, 2.69188308e-06f, 3.6793715e-06f,
+    5.0040212e-06f, 6.77162825e-06f, 9.1179154e-06f, 1.2215929e-05f, 1.62849628e-05f,
+    2.16010503e-05f, 2.85096194e-05f, 3.74400588e-05f, 4.89226804e-05f, 6.36081968e-05f,
+    8.2289378e-05f, 0.00010592609f, 0.000135672177f, 0.000172904838f, 0.000219256443f,
+    0.00027664681f, 0.000347318273f, 0.000433868467f, 0.000539283326f, 0.000666968117f,
+    0.000820768997f, 0.00100499881f, 0.00122444308f, 0.00148436404f, 0.00179048441f,
+    0.00214896537f, 0.00256635412f, 0.00304952613f, 0.00360559369f, 0.00424179342f,
+    0.00496536307f, 0.00578336837f, 0.00670253672f, 0.00772905303f, 0.00886832736f,
+    0.0101247858f, 0.0115016019f, 0.0130004799f, 0.0146214012f, 0.0163624045f,
+    0.0182193909f, 0.02018594f, 0.0222532116f, 0.0244098417f, 0.0266419295f,
+    0.0289330985f, 0.0312645957f, 0.0336154699f, 0.0359628461f, 0.0382822491f,
+    0.040547993f, 0.0427336358f, 0.0448124669f, 0.0467580445f, 0.0485447608f,
+    0.0501483865f, 0.0515466034f, 0.0527195483f, 0.05365026f, 0.0543250963f,
+    0.0547340661f, 0.0548710749f
+};
+
+static const StdRate std_rates[] = {
+    {100, 0.99529868f, 0.99764934f, kernel_100, STD_TAPS_100,
+     STD_STA_100, STD_LTA_100},
+    {128, 0.99632521f, 0.9981626f, kernel_128, STD_TAPS_128,
+     STD_STA_128, STD_LTA_128},
+    {200, 0.99764658f, 0.99882329f, kernel_200, STD_TAPS_200,
+     STD_STA_200, STD_LTA_200}
+};
+
+// Le finestre costanti devono seguire config.h
+_Static_assert(STD_STA_128 == (int)(STA_WINDOW_S * 128) &&
+               STD_LTA_128 == (int)(LTA_WINDOW_S * 128) &&
+               STD_STA_100 == (int)(STA_WINDOW_S * 100) &&
+               STD_LTA_100 == (int)(LTA_WINDOW_S * 100) &&
+               STD_STA_200 == (int)(STA_WINDOW_S * 200) &&
+               STD_LTA_200 == (int)(LTA_WINDOW_S * 200),
+               "finestre STA/LTA standard non allineate a config.h");
+
+const StdRate* std_rate_find(int fs) {
+    for (size_t i = 0; i < sizeof(std_rates) / sizeof(std_rates[0]); i++) {
+        if (std_rates[i].fs == fs) return &std_rates[i];
+    }
+    return NULL;
+}
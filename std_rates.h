@@ -0,0 +1,32 @@
+#ifndef STD_RATES_H
+#define STD_RATES_H
+
+// Frequenze standard (100, 128, 200 Hz): coefficienti HP, kernel gaussiano
+// precalcolato e lunghezze costanti per le varianti specializzate dei loop
+// caldi. Le altre frequenze usano il percorso generico
+
+// Taps effettivi del kernel con FIR_PRUNE_TOL (fir_simd.c)
+#define STD_TAPS_100 33
+#define STD_TAPS_128 42
+#define STD_TAPS_200 66
+
+// Finestre STA/LTA con STA_WINDOW_S e LTA_WINDOW_S (trigger.c)
+#define STD_STA_100 50
+#define STD_LTA_100 600
+#define STD_STA_128 64
+#define STD_LTA_128 768
+#define STD_STA_200 100
+#define STD_LTA_200 1200
+
+typedef struct {
+    int fs;
+    float hp_a, hp_b;
+    const float *kernel;      // 2 * fs taps, come create_gaussian_kernel
+    int eff_taps;             // STD_TAPS_*
+    int sta_len, lta_len;     // STD_STA_*, STD_LTA_*
+} StdRate;
+
+// Descrizione della frequenza standard fs, NULL per frequenze custom
+const StdRate* std_rate_find(int fs);
+
+#endif
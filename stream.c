@@ -0,0 +1,381 @@
+#include "stream.h"
+#include "drift_analysis.h"
+#include "config.h"
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void reset_results(AnalysisResults *results) {
+    results->pgd_base = 0.0f;
+    results->max_drift_abs = 0.0f;
+    results->max_drift_norm = 0.0f;
+    results->max_prob = 0.0f;
+    results->alarm_triggered = 0;
+    results->alarm_idx = -1;
+}
+
+int stream_init(StreamEngine *eng, FilterConfig *filter,
+                TriggerParams *trigger, AlarmThreshold *threshold,
+                float ptm_len_s, float building_height) {
+    eng->filter = filter;
+    eng->trigger = trigger;
+    eng->threshold = *threshold;
+    eng->pgd_critical = pgd_critical(threshold->drift_limit,
+                                     threshold->prob_threshold);
+    eng->norm_height = (2.0f / 3.0f) * building_height;
+
+    eng->sta_len = (int)(trigger->STA_len_s * filter->fs);
+    eng->lta_len = (int)(trigger->LTA_len_s * filter->fs);
+    eng->ptm_len = (int)(ptm_len_s * filter->fs);
+    eng->start_idx = filter->fir_warmup + eng->lta_len - 1;
+
+    eng->top = (StreamChannel){0};
+    eng->base = (StreamChannel){0};
+    eng->top.hp_b_in = filter->hp_b;
+    eng->base.hp_b_in = filter->hp_b;
+    eng->fir_pos = 0;
+
+    // Il FIR serve solo sul TOP (unico canale usato dal trigger)
+    int fir_ok;
+    eng->rg_top = (RecursiveGaussianStream){0};
+    if (filter->fir_mode == FIR_MODE_RECURSIVE) {
+        fir_ok = rg_stream_init(&eng->rg_top, &filter->rg);
+    } else {
+        eng->top.fir_hist = (float*)calloc(2 * filter->filter_len, sizeof(float));
+        fir_ok = eng->top.fir_hist != NULL;
+    }
+    // Storia del CF fino all'LTA massimo: le finestre si cambiano a caldo
+    eng->cf_cap = (int)(STREAM_MAX_LTA_S * filter->fs);
+    if (eng->cf_cap < eng->lta_len) eng->cf_cap = eng->lta_len;
+    eng->cf_ring = (float*)calloc(eng->cf_cap, sizeof(float));
+    eng->cf_pos = 0;
+    eng->sta_sum = 0.0;
+    eng->lta_sum = 0.0;
+    eng->ratio = 0.0f;
+    eng->live = NULL;
+
+    eng->state = STREAM_LISTENING;
+    eng->n_pushed = 0;
+    eng->trigger_idx = -1;
+    eng->alarm_idx = -1;
+    eng->ptm_end = 0;
+    reset_results(&eng->results);
+    eng->stats = (StreamStats){0};
+
+    trigger->trigger_idx = -1;
+    trigger->triggered = 0;
+
+    if (!fir_ok || !eng->cf_ring) {
+        stream_free(eng);
+        return 0;
+    }
+    return 1;
+}
+
+void stream_set_input_scale(StreamEngine *eng, float scale_top,
+                            float scale_base) {
+    eng->top.hp_b_in = eng->filter->hp_b * scale_top;
+    eng->base.hp_b_in = eng->filter->hp_b * scale_base;
+}
+
+// Somme STA/LTA ricalcolate dalla storia del CF per le finestre correnti,
+// come le avrebbe accumulate stream_push dall'avvio
+static void rebuild_sums(StreamEngine *eng) {
+    int warmup = eng->filter->fir_warmup;
+    long last = eng->n_pushed - 1;
+    eng->sta_sum = 0.0;
+    eng->lta_sum = 0.0;
+    if (last < warmup) return;
+
+    long lta_lo = last - eng->lta_len + 1;
+    if (lta_lo < warmup) lta_lo = warmup;
+    long sta_lo = last - eng->sta_len + 1;
+    if (sta_lo < eng->start_idx - eng->sta_len + 1) {
+        sta_lo = eng->start_idx - eng->sta_len + 1;
+    }
+    for (long k = lta_lo; k <= last; k++) {
+        float a = eng->cf_ring[(k - warmup) % eng->cf_cap];
+        eng->lta_sum += a;
+        if (k >= sta_lo) eng->sta_sum += a;
+    }
+}
+
+int stream_reconfigure(StreamEngine *eng, float sta_s, float lta_s,
+                       float trigger_threshold, const AlarmThreshold *threshold,
+                       float ptm_len_s, float building_height) {
+    FilterConfig *f = eng->filter;
+    int sta_len = (int)(sta_s * f->fs);
+    int lta_len = (int)(lta_s * f->fs);
+    if (sta_len < 1 || lta_len <= sta_len || lta_len > eng->cf_cap ||
+        building_height <= 0.0f || ptm_len_s <= 0.0f) {
+        return 0;
+    }
+
+    TriggerParams *trigger = eng->trigger;
+    trigger->STA_len_s = sta_s;
+    trigger->LTA_len_s = lta_s;
+    trigger->threshold = trigger_threshold;
+    eng->threshold = *threshold;
+    eng->pgd_critical = pgd_critical(threshold->drift_limit,
+                                     threshold->prob_threshold);
+    eng->norm_height = (2.0f / 3.0f) * building_height;
+
+    eng->sta_len = sta_len;
+    eng->lta_len = lta_len;
+    eng->start_idx = f->fir_warmup + lta_len - 1;
+    rebuild_sums(eng);
+
+    // Evento in corso: la finestra post-trigger si misura dal trigger
+    eng->ptm_len = (int)(ptm_len_s * f->fs);
+    if (eng->state == STREAM_MONITORING) {
+        eng->ptm_end = eng->trigger_idx + eng->ptm_len;
+    }
+    if (eng->live) eng->live->last_pgd = -1.0f;
+    return 1;
+}
+
+void stream_set_live(StreamEngine *eng, LivePublisher *pub) {
+    eng->live = pub;
+}
+
+// Snapshot del campione i nel segmento live; la probabilità si ricalcola
+// solo quando il PGD cresce (monotono nella finestra post-trigger)
+static void publish_live(StreamEngine *eng, long i, int events, double t_ns) {
+    LivePublisher *pub = eng->live;
+    LiveSnapshot *s = &pub->snap;
+    const AnalysisResults *r = &eng->results;
+
+    if (events & STREAM_EVENT_TRIGGER) {
+        s->n_triggers++;
+        s->trigger_idx = i;
+        s->alarm = 0;
+        s->alarm_idx = -1;
+    }
+    if (r->pgd_base != pub->last_pgd) {
+        s->prob = calculate_exceedance_probability(r->pgd_base,
+                                                   eng->threshold.drift_limit);
+        pub->last_pgd = r->pgd_base;
+    }
+    if (events & STREAM_EVENT_ALARM) {
+        s->n_alarms++;
+        s->alarm = 1;
+        s->alarm_idx = i;
+        s->alarm_ns = (uint64_t)t_ns;
+    }
+    s->sample_idx = i;
+    s->update_ns = (uint64_t)t_ns;
+    s->sta_lta = eng->ratio;
+    s->pgd_base = r->pgd_base;
+    s->max_drift_abs = r->max_drift_abs;
+    s->max_drift_norm = r->max_drift_norm;
+    s->state = eng->state;
+    live_publish(pub, s);
+}
+
+// High-pass ricorsivo, stessa formula di apply_highpass_filter
+static float highpass_step(StreamChannel *ch, float x, long i,
+                           float hp_a, float hp_b) {
+    float y = (i == 0) ? 0.0f : x * hp_b - ch->hp_x_prev * hp_b + hp_a * ch->hp_y_prev;
+    ch->hp_x_prev = x;
+    ch->hp_y_prev = y;
+    return y;
+}
+
+// Integrazione acc -> vel -> HP -> spostamento, come perform_drift_analysis
+static void integrate_step(StreamChannel *ch, float acc_hp, float dt,
+                           float hp_a, float hp_b) {
+    float vel_unf = ch->vel_unf + (ch->acc_hp_prev + acc_hp) * 0.5f * dt;
+    float vel_filt = vel_unf * hp_b - ch->vel_unf * hp_b + hp_a * ch->vel_filt;
+
+    ch->disp = ch->disp + (ch->vel_filt + vel_filt) * 0.5f * dt;
+    ch->vel_unf = vel_unf;
+    ch->vel_filt = vel_filt;
+    ch->acc_hp_prev = acc_hp;
+}
+
+static void start_monitoring(StreamEngine *eng, long i) {
+    eng->state = STREAM_MONITORING;
+    eng->trigger_idx = i;
+    eng->alarm_idx = -1;
+    eng->ptm_end = i + eng->ptm_len;
+    reset_results(&eng->results);
+
+    StreamChannel *chs[2] = { &eng->top, &eng->base };
+    for (int c = 0; c < 2; c++) {
+        chs[c]->vel_unf = 0.0f;
+        chs[c]->vel_filt = 0.0f;
+        chs[c]->disp = 0.0f;
+    }
+}
+
+// Passo post-trigger: ritorna maschera eventi
+static int monitor_step(StreamEngine *eng, long i, StreamEvent *ev) {
+    FilterConfig *f = eng->filter;
+    AnalysisResults *r = &eng->results;
+
+    integrate_step(&eng->top, eng->top.hp_y_prev, f->dt, f->hp_a, f->hp_b);
+    integrate_step(&eng->base, eng->base.hp_y_prev, f->dt, f->hp_a, f->hp_b);
+
+    float drift_abs = eng->top.disp - eng->base.disp;
+    float drift_norm = drift_abs / eng->norm_height;
+
+    float abs_disp_base = fabsf(eng->base.disp);
+    if (abs_disp_base > r->pgd_base) r->pgd_base = abs_disp_base;
+    if (fabsf(drift_abs) > r->max_drift_abs) r->max_drift_abs = fabsf(drift_abs);
+    if (fabsf(drift_norm) > r->max_drift_norm) r->max_drift_norm = fabsf(drift_norm);
+
+    // Confronto sul PGD; la probabilità serve solo per gli eventi
+    int alarm;
+    if (eng->pgd_critical >= 0.0f) {
+        alarm = r->pgd_base >= eng->pgd_critical;
+    } else {
+        alarm = calculate_exceedance_probability(r->pgd_base,
+                    eng->threshold.drift_limit) > eng->threshold.prob_threshold;
+    }
+    int end = i + 1 >= eng->ptm_end;
+    if (!alarm && !end) return STREAM_EVENT_NONE;
+
+    float prob = calculate_exceedance_probability(r->pgd_base,
+                                                  eng->threshold.drift_limit);
+    r->max_prob = prob;       // Crescente con pgd_base
+    eng->state = STREAM_HOLDOFF;
+    ev->prob = prob;
+    if (alarm) {
+        // Indici in long (stazioni sempre accese): gli int di
+        // AnalysisResults e TriggerParams valgono solo finché ci stanno
+        r->alarm_triggered = 1;
+        r->alarm_idx = (i <= INT_MAX) ? (int)i : -1;
+        eng->alarm_idx = i;
+        return STREAM_EVENT_ALARM;
+    }
+    return STREAM_EVENT_PTM_END;
+}
+
+int stream_push(StreamEngine *eng, float acc_top, float acc_base,
+                StreamEvent *ev) {
+    double t0 = now_ns();
+    FilterConfig *f = eng->filter;
+    long i = eng->n_pushed++;
+    int events = STREAM_EVENT_NONE;
+
+    float hp_top = highpass_step(&eng->top, acc_top, i, f->hp_a, eng->top.hp_b_in);
+    highpass_step(&eng->base, acc_base, i, f->hp_a, eng->base.hp_b_in);
+
+    int L = f->filter_len;
+    int warmup = f->fir_warmup;
+    float fir = 0.0f;
+    if (f->fir_mode == FIR_MODE_RECURSIVE) {
+        float y = rg_stream_push(&eng->rg_top, hp_top, i);
+        if (i >= warmup) fir = y;
+    } else {
+        // Storia FIR in doppia copia: finestra sempre contigua
+        float *hist = eng->top.fir_hist;
+        hist[eng->fir_pos] = hp_top;
+        hist[eng->fir_pos + L] = hp_top;
+
+        if (i >= warmup) {
+            const float *win = hist + eng->fir_pos + L;
+            for (int k = f->kernel_offset; k < L; k++) {
+                fir += win[-k] * f->kernel[k];
+            }
+        }
+        if (++eng->fir_pos == L) eng->fir_pos = 0;
+    }
+    eng->top.acc_fir = fir;
+
+    if (eng->state == STREAM_MONITORING) {
+        events |= monitor_step(eng, i, ev);
+    }
+
+    // STA/LTA con somme mobili in double: l'arrotondamento di somme e
+    // sottrazioni (anche dopo un evento forte) resta sotto la precisione
+    // float del rapporto, quindi costo fisso per campione senza ricalcoli
+    if (i >= warmup) {
+        float a = fabsf(fir);
+        int sta_pos = eng->cf_pos - eng->sta_len;
+        if (sta_pos < 0) sta_pos += eng->cf_cap;
+        int lta_pos = eng->cf_pos - eng->lta_len;
+        if (lta_pos < 0) lta_pos += eng->cf_cap;
+
+        if (i <= eng->start_idx) {
+            eng->lta_sum += a;
+            if (i >= eng->start_idx - eng->sta_len + 1) eng->sta_sum += a;
+        } else {
+            eng->sta_sum += a - eng->cf_ring[sta_pos];
+            eng->lta_sum += a - eng->cf_ring[lta_pos];
+        }
+        eng->cf_ring[eng->cf_pos] = a;
+        if (++eng->cf_pos == eng->cf_cap) eng->cf_pos = 0;
+
+        if (i >= eng->start_idx) {
+            float sta_avg = (float)(eng->sta_sum / eng->sta_len);
+            float lta_avg = (float)(eng->lta_sum / eng->lta_len);
+            float ratio = (lta_avg > 1e-9f) ? sta_avg / lta_avg : 0.0f;
+            int above = ratio > eng->trigger->threshold;
+            eng->ratio = ratio;
+
+            if (eng->state == STREAM_LISTENING && above) {
+                eng->trigger->trigger_idx = (i <= INT_MAX) ? (int)i : -1;
+                eng->trigger->triggered = 1;
+                ev->ratio = ratio;
+                events |= STREAM_EVENT_TRIGGER;
+                start_monitoring(eng, i);
+                eng->top.acc_hp_prev = hp_top;
+                eng->base.acc_hp_prev = eng->base.hp_y_prev;
+                if (eng->ptm_len <= 1) {
+                    eng->state = STREAM_HOLDOFF;
+                    events |= STREAM_EVENT_PTM_END;
+                }
+            } else if (eng->state == STREAM_HOLDOFF && !above) {
+                // Riarmo solo quando STA/LTA rientra sotto soglia
+                eng->state = STREAM_LISTENING;
+            }
+        }
+    }
+
+    double t1 = now_ns();
+    double dt_ns = t1 - t0;
+    if (eng->live) publish_live(eng, i, events, t1);
+    eng->stats.samples++;
+    eng->stats.total_ns += dt_ns;
+    if (dt_ns > eng->stats.max_ns) eng->stats.max_ns = dt_ns;
+
+    if (events) {
+        ev->type = events;
+        ev->sample_idx = i;
+        ev->proc_ns = dt_ns;
+    }
+    return events;
+}
+
+int stream_push_packet(StreamEngine *eng, const float *acc_top,
+                       const float *acc_base, int count,
+                       StreamEvent *events, int max_events) {
+    int n_events = 0;
+    StreamEvent ev;
+
+    for (int j = 0; j < count; j++) {
+        if (stream_push(eng, acc_top[j], acc_base[j], &ev) &&
+            n_events < max_events) {
+            events[n_events++] = ev;
+        }
+    }
+    return n_events;
+}
+
+void stream_free(StreamEngine *eng) {
+    free(eng->top.fir_hist);
+    free(eng->base.fir_hist);
+    free(eng->cf_ring);
+    rg_stream_free(&eng->rg_top);
+    eng->top.fir_hist = NULL;
+    eng->base.fir_hist = NULL;
+    eng->cf_ring = NULL;
+}
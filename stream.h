@@ -0,0 +1,108 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "types.h"
+#include "recursive_gaussian.h"
+#include "live.h"
+
+// Eventi emessi dal motore streaming (maschera di bit)
+#define STREAM_EVENT_NONE     0
+#define STREAM_EVENT_TRIGGER  1
+#define STREAM_EVENT_ALARM    2
+#define STREAM_EVENT_PTM_END  4
+
+typedef enum {
+    STREAM_LISTENING,     // In attesa di trigger (STA/LTA attivo)
+    STREAM_MONITORING,    // Finestra post-trigger in corso
+    STREAM_HOLDOFF        // Evento concluso, attesa rientro STA/LTA
+} StreamState;
+
+typedef struct {
+    int type;             // Maschera STREAM_EVENT_*
+    long sample_idx;      // Indice campione che ha generato l'evento
+    float ratio;          // STA/LTA al trigger
+    float prob;           // Probabilità all'allarme
+    double proc_ns;       // Tempo di elaborazione del campione (ns)
+} StreamEvent;
+
+// Stato di un canale: HP ricorsivo, storia FIR, integratori
+typedef struct {
+    float hp_x_prev;      // Ultimo campione in ingresso HP
+    float hp_y_prev;      // Ultima uscita HP
+    float hp_b_in;        // hp_b con il fattore di unità dell'ingresso
+    float *fir_hist;      // Storia acc_hp, doppia copia (2 * filter_len)
+    float vel_unf;        // Velocità non filtrata
+    float vel_filt;       // Velocità filtrata
+    float disp;           // Spostamento
+    float acc_hp_prev;    // acc_hp al campione precedente
+    float acc_fir;        // Ultima uscita FIR
+} StreamChannel;
+
+typedef struct {
+    long samples;         // Campioni elaborati
+    double total_ns;      // Tempo totale di elaborazione
+    double max_ns;        // Caso peggiore per campione
+} StreamStats;
+
+typedef struct {
+    FilterConfig *filter;
+    TriggerParams *trigger;
+    AlarmThreshold threshold;
+    float pgd_critical;   // Allarme quando pgd_base >= pgd_critical
+    float norm_height;
+    int sta_len, lta_len, ptm_len;
+    int start_idx;        // Primo indice valido per STA/LTA
+
+    StreamChannel top, base;
+    int fir_pos;          // Posizione corrente nella storia FIR
+    RecursiveGaussianStream rg_top;  // Passa-basso in modalità ricorsiva
+
+    float *cf_ring;       // |acc_fir| TOP sugli ultimi cf_cap campioni
+    int cf_cap;           // Capacità: LTA massimo (STREAM_MAX_LTA_S)
+    int cf_pos;
+    double sta_sum, lta_sum; // Somme mobili: in double non serve ricalcolarle
+    float ratio;          // Ultimo STA/LTA calcolato
+
+    StreamState state;
+    long n_pushed;        // Campioni ricevuti
+    long trigger_idx;     // Trigger dell'evento corrente (-1 = nessuno)
+    long alarm_idx;       // Allarme dell'evento corrente (-1 = nessuno)
+    long ptm_end;         // Fine finestra post-trigger (esclusa)
+    AnalysisResults results;
+    StreamStats stats;
+    LivePublisher *live;  // Stato live in memoria condivisa (NULL = no)
+} StreamEngine;
+
+// Inizializza motore (memoria costante, indipendente dalla durata)
+int stream_init(StreamEngine *eng, FilterConfig *filter,
+                TriggerParams *trigger, AlarmThreshold *threshold,
+                float ptm_len_s, float building_height);
+
+// Fattore verso m/s² dei campioni in ingresso (default 1), assorbito in hp_b
+void stream_set_input_scale(StreamEngine *eng, float scale_top,
+                            float scale_base);
+
+// Nuove finestre, soglie e profilo edificio dal campione successivo, senza
+// toccare HP, storia FIR e integratori: le somme STA/LTA si ricalcolano
+// dalla storia del CF. Ritorna 0 (nulla cambiato) se i valori non sono
+// ammissibili o l'LTA supera STREAM_MAX_LTA_S
+int stream_reconfigure(StreamEngine *eng, float sta_s, float lta_s,
+                       float trigger_threshold, const AlarmThreshold *threshold,
+                       float ptm_len_s, float building_height);
+
+// Pubblica lo stato a ogni campione nel segmento condiviso di pub
+void stream_set_live(StreamEngine *eng, LivePublisher *pub);
+
+// Elabora un campione TOP/BASE (m/s²), ritorna maschera eventi
+int stream_push(StreamEngine *eng, float acc_top, float acc_base,
+                StreamEvent *ev);
+
+// Elabora un pacchetto di campioni, ritorna numero eventi scritti
+int stream_push_packet(StreamEngine *eng, const float *acc_top,
+                       const float *acc_base, int count,
+                       StreamEvent *events, int max_events);
+
+// Libera risorse
+void stream_free(StreamEngine *eng);
+
+#endif
@@ -0,0 +1,98 @@
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TRACE_POLL_NS 1000000       // Attesa del thread tra due controlli
+
+// Formatta i record pubblicati fino a head
+static void trace_drain(TraceRing *tr) {
+    unsigned long h = atomic_load_explicit(&tr->head, memory_order_acquire);
+    unsigned long capacity = tr->mask + 1;
+    
+    while (tr->tail < h) {
+        if (h - tr->tail > capacity) {
+            tr->dropped += h - tr->tail - capacity;
+            tr->tail = h - capacity;
+        }
+        TraceRecord r = tr->rec[tr->tail & tr->mask];
+        // Scartato se il produttore l'ha sovrascritto durante la copia
+        unsigned long now = atomic_load_explicit(&tr->head, memory_order_acquire);
+        if (now - tr->tail > capacity) {
+            h = now;
+            continue;
+        }
+        fprintf(tr->fp, "%.3f, %.6e, %.6e, %.2f, %.2f\n",
+                r.t, r.pgd, r.drift_abs, r.drift_norm, r.prob);
+        tr->tail++;
+    }
+}
+
+static void* trace_thread(void *arg) {
+    TraceRing *tr = (TraceRing*)arg;
+    struct timespec pause = {0, TRACE_POLL_NS};
+    
+    while (!atomic_load_explicit(&tr->done, memory_order_acquire)) {
+        trace_drain(tr);
+        nanosleep(&pause, NULL);
+    }
+    trace_drain(tr);
+    return NULL;
+}
+
+int trace_open(TraceRing *tr, const TraceOptions *opt, long max_steps) {
+    memset(tr, 0, sizeof(*tr));
+    atomic_init(&tr->head, 0);
+    atomic_init(&tr->done, 0);
+    tr->rec = &tr->scratch;
+    tr->decimation = (opt && opt->decimation > 1) ? opt->decimation : 1;
+    
+    if (!opt || !opt->filename) return 0;
+    
+    // Capacità sufficiente per l'intera finestra: nessuna perdita a fine run
+    unsigned long need = (unsigned long)(max_steps / tr->decimation + 1);
+    unsigned long capacity = 1;
+    while (capacity < need) capacity <<= 1;
+    
+    TraceRecord *rec = (TraceRecord*)malloc(capacity * sizeof(TraceRecord));
+    FILE *fp = rec ? fopen(opt->filename, "w") : NULL;
+    if (!fp) {
+        free(rec);
+        return 0;
+    }
+    // Pagine toccate subito, non durante l'analisi
+    memset(rec, 0, capacity * sizeof(TraceRecord));
+    
+    tr->rec = rec;
+    tr->mask = capacity - 1;
+    tr->fp = fp;
+    tr->enabled = 1;
+    fprintf(fp, "# t(s), PGD_base(m), Drift_abs(m), Drift_norm(mm/m), Prob(%%)\n");
+    
+    if (opt->background &&
+        pthread_create(&tr->thread, NULL, trace_thread, tr) == 0) {
+        tr->running = 1;
+    }
+    return 1;
+}
+
+void trace_close(TraceRing *tr) {
+    if (tr->running) {
+        atomic_store_explicit(&tr->done, 1, memory_order_release);
+        pthread_join(tr->thread, NULL);
+        tr->running = 0;
+    }
+    if (tr->fp) {
+        trace_drain(tr);
+        if (tr->dropped) {
+            printf("⚠ ATTENZIONE: %lu record di debug persi (ring pieno)\n",
+                   tr->dropped);
+        }
+        fclose(tr->fp);
+    }
+    if (tr->rec != &tr->scratch) free(tr->rec);
+    tr->rec = &tr->scratch;
+    tr->mask = 0;
+    tr->enabled = 0;
+    tr->fp = NULL;
+}
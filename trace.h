@@ -0,0 +1,60 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// Record grezzo del log post-trigger (già nelle unità del file debug)
+typedef struct {
+    float t;              // Tempo (s)
+    float pgd;            // PGD base (m)
+    float drift_abs;      // Drift assoluto max (m)
+    float drift_norm;     // Drift normalizzato max (mm/m)
+    float prob;           // Probabilità (%)
+} TraceRecord;
+
+// Opzioni del log debug
+typedef struct {
+    const char *filename; // NULL = nessun log
+    int decimation;       // Un record ogni N campioni (>= 1)
+    int background;       // Formattazione in un thread separato
+} TraceOptions;
+
+// Ring preallocato: il produttore scrive solo memoria, la formattazione
+// avviene in trace_close o nel thread di background
+typedef struct {
+    TraceRecord *rec;
+    unsigned long mask;             // Capacità - 1 (potenza di 2)
+    atomic_ulong head;              // Record pubblicati
+    unsigned long tail;             // Record già formattati
+    unsigned long dropped;          // Persi per ring pieno (solo background)
+    int decimation;
+    int enabled;                    // Log aperto (accanto a decimation)
+    FILE *fp;
+    pthread_t thread;
+    atomic_int done;
+    int running;
+    TraceRecord scratch;            // Destinazione se il log è disattivato
+} TraceRing;
+
+// Prepara il ring per max_steps campioni e scrive l'intestazione
+int trace_open(TraceRing *tr, const TraceOptions *opt, long max_steps);
+
+// Registra il record del passo step (senza I/O né salti sul file)
+static inline void trace_push(TraceRing *tr, long step, const TraceRecord *r) {
+    unsigned long h = atomic_load_explicit(&tr->head, memory_order_relaxed);
+    tr->rec[h & tr->mask] = *r;
+    atomic_store_explicit(&tr->head, h + (step % tr->decimation == 0),
+                          memory_order_release);
+}
+
+// Vero se il record del passo step finisce nel log
+static inline int trace_wants(const TraceRing *tr, long step) {
+    return tr->enabled && step % tr->decimation == 0;
+}
+
+// Formatta i record rimanenti, chiude il file e libera il ring
+void trace_close(TraceRing *tr);
+
+#endif
@@ -1,38 +1,54 @@
 // trigger.c
 #include "trigger.h"
+#include "config.h"
+#include "std_rates.h"
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 void init_trigger_params(TriggerParams *params, float sta_s, float lta_s) {
     params->STA_len_s = sta_s;
     params->LTA_len_s = lta_s;
-    params->threshold = 4.0f;
+    params->threshold = STA_LTA_THRESHOLD;
     params->trigger_idx = -1;
     params->triggered = 0;
+    params->trigger_ratio = 0.0f;
 }
 
-int find_trigger(float *signal, int n, TriggerParams *params, 
-                 FilterConfig *filter_cfg) {
-    int sta_len = (int)(params->STA_len_s * filter_cfg->fs);
-    int lta_len = (int)(params->LTA_len_s * filter_cfg->fs);
-    int start_idx = filter_cfg->filter_len + lta_len - 1;
-    
-    float sta_sum = 0.0f;
-    float lta_sum = 0.0f;
+void sta_lta_init(StaLtaScan *scan, TriggerParams *params,
+                  FilterConfig *filter_cfg) {
+    scan->sta_len = (int)(params->STA_len_s * filter_cfg->fs);
+    scan->lta_len = (int)(params->LTA_len_s * filter_cfg->fs);
+    scan->start_idx = filter_cfg->fir_warmup + scan->lta_len - 1;
+    scan->sta_sum = 0.0f;
+    scan->lta_sum = 0.0f;
+}
+
+void sta_lta_prime(StaLtaScan *scan, const float *signal, int origin) {
+    int start_idx = scan->start_idx;
     
     // Inizializza finestre
-    for (int i = start_idx - lta_len + 1; i <= start_idx; i++) {
-        lta_sum += fabsf(signal[i]);
-        if (i >= start_idx - sta_len + 1) {
-            sta_sum += fabsf(signal[i]);
+    for (int i = start_idx - scan->lta_len + 1; i <= start_idx; i++) {
+        scan->lta_sum += fabsf(signal[i - origin]);
+        if (i >= start_idx - scan->sta_len + 1) {
+            scan->sta_sum += fabsf(signal[i - origin]);
         }
     }
+}
+
+// Corpo della scansione; espanso con finestre costanti per le frequenze
+// standard (divisioni per costante, offset immediati)
+static inline __attribute__((always_inline))
+int sta_lta_scan_body(StaLtaScan *scan, const float *signal, int origin,
+                      int from, int to, TriggerParams *params,
+                      int sta_len, int lta_len) {
+    float sta_sum = scan->sta_sum, lta_sum = scan->lta_sum;
     
     // Cerca trigger
-    for (int i = start_idx; i < n; i++) {
-        if (i > start_idx) {
-            sta_sum += fabsf(signal[i]) - fabsf(signal[i - sta_len]);
-            lta_sum += fabsf(signal[i]) - fabsf(signal[i - lta_len]);
+    for (int i = from; i < to; i++) {
+        if (i > scan->start_idx) {
+            sta_sum += fabsf(signal[i - origin]) - fabsf(signal[i - sta_len - origin]);
+            lta_sum += fabsf(signal[i - origin]) - fabsf(signal[i - lta_len - origin]);
         }
         
         float sta_avg = sta_sum / sta_len;
@@ -42,12 +58,243 @@ int find_trigger(float *signal, int n, TriggerParams *params,
         if (ratio > params->threshold) {
             params->trigger_idx = i;
             params->triggered = 1;
-            printf("✓ TRIGGER: indice=%d, t=%.3fs, STA/LTA=%.2f\n\n", 
-                   i, i * filter_cfg->dt, ratio);
+            params->trigger_ratio = ratio;
+            scan->sta_sum = sta_sum;
+            scan->lta_sum = lta_sum;
             return 1;
         }
     }
     
-    printf("✗ NESSUN TRIGGER\n");
+    scan->sta_sum = sta_sum;
+    scan->lta_sum = lta_sum;
+    return 0;
+}
+
+int sta_lta_scan(StaLtaScan *scan, const float *signal, int origin,
+                 int from, int to, TriggerParams *params) {
+    int sta_len = scan->sta_len, lta_len = scan->lta_len;
+    if (sta_len == STD_STA_100 && lta_len == STD_LTA_100) {
+        return sta_lta_scan_body(scan, signal, origin, from, to, params,
+                                 STD_STA_100, STD_LTA_100);
+    }
+    if (sta_len == STD_STA_128 && lta_len == STD_LTA_128) {
+        return sta_lta_scan_body(scan, signal, origin, from, to, params,
+                                 STD_STA_128, STD_LTA_128);
+    }
+    if (sta_len == STD_STA_200 && lta_len == STD_LTA_200) {
+        return sta_lta_scan_body(scan, signal, origin, from, to, params,
+                                 STD_STA_200, STD_LTA_200);
+    }
+    return sta_lta_scan_body(scan, signal, origin, from, to, params,
+                             sta_len, lta_len);
+}
+
+int find_trigger(float *signal, int n, TriggerParams *params, 
+                 FilterConfig *filter_cfg) {
+    StaLtaScan scan;
+    sta_lta_init(&scan, params, filter_cfg);
+    sta_lta_prime(&scan, signal, 0);
+    
+    if (sta_lta_scan(&scan, signal, 0, scan.start_idx, n, params)) {
+        report_trigger(params, filter_cfg);
+        return 1;
+    }
+    
+    LOG_INFO("✗ NESSUN TRIGGER\n");
     return 0;
-}
\ No newline at end of file
+}
+
+void report_trigger(const TriggerParams *params, const FilterConfig *filter_cfg) {
+    LOG_INFO("✓ TRIGGER: indice=%d, t=%.3fs, STA/LTA=%.2f\n\n", 
+             params->trigger_idx, params->trigger_idx * filter_cfg->dt,
+             params->trigger_ratio);
+}
+
+// ---- Banco di rivelatori ----
+
+static const char *detector_names[DETECTOR_COUNT] = {
+    "STA/LTA", "Ricorsivo", "Z", "Kurtosis"
+};
+
+const char* detector_name(DetectorType det) {
+    return (det >= 0 && det < DETECTOR_COUNT) ? detector_names[det] : "?";
+}
+
+void init_trigger_bank_params(TriggerBankParams *bank,
+                              const TriggerParams *trigger) {
+    bank->sta_s = trigger->STA_len_s;
+    bank->lta_s = trigger->LTA_len_s;
+    bank->kurt_s = KURTOSIS_WINDOW_S;
+    bank->threshold[DETECTOR_STA_LTA] = trigger->threshold;
+    bank->threshold[DETECTOR_RECURSIVE] = RECURSIVE_THRESHOLD;
+    bank->threshold[DETECTOR_Z] = Z_DETECT_THRESHOLD;
+    bank->threshold[DETECTOR_KURTOSIS] = KURTOSIS_THRESHOLD;
+}
+
+static void bank_record(TriggerBankResult *r, int det, int i, float value,
+                        float threshold) {
+    if (r->pick_idx[det] < 0 && value > threshold) {
+        r->pick_idx[det] = i;
+        r->pick_value[det] = value;
+    }
+    if (value > r->max_value[det]) {
+        r->max_value[det] = value;
+        r->max_idx[det] = i;
+    }
+}
+
+// Somma mobile compensata (Kahan): l'arrotondamento di ogni termine si
+// recupera al successivo, così togliere potenze grandi dopo un evento non
+// lascia residui e la finestra non va mai riletta
+typedef struct {
+    double sum, comp;
+} KahanSum;
+
+static inline void kahan_add(KahanSum *k, double x) {
+    double y = x - k->comp;
+    double t = k->sum + y;
+    k->comp = (t - k->sum) - y;
+    k->sum = t;
+}
+
+int run_trigger_bank(const float *signal, int n, const FilterConfig *filter_cfg,
+                     const TriggerBankParams *bank, TriggerBankResult *r,
+                     int keep_trace) {
+    int warmup = filter_cfg->fir_warmup;
+    int sta_len = (int)(bank->sta_s * filter_cfg->fs);
+    int lta_len = (int)(bank->lta_s * filter_cfg->fs);
+    int kurt_len = (int)(bank->kurt_s * filter_cfg->fs);
+    if (kurt_len > lta_len) kurt_len = lta_len;
+    if (kurt_len < 4) kurt_len = 4;
+    
+    // Stesso primo indice di find_trigger: finestre LTA complete
+    int first = warmup + lta_len - 1;
+    r->first = first;
+    r->n = n;
+    r->trace = NULL;
+    for (int d = 0; d < DETECTOR_COUNT; d++) {
+        r->pick_idx[d] = r->max_idx[d] = -1;
+        r->pick_value[d] = r->max_value[d] = 0.0f;
+    }
+    if (sta_len < 1 || lta_len <= sta_len || first >= n) return 0;
+    
+    if (keep_trace) {
+        r->trace = (float*)calloc((size_t)(n - first) * DETECTOR_COUNT, sizeof(float));
+        if (!r->trace) return 0;
+    }
+    // Storia delle energie STA per lo Z-detector
+    double *z_ring = (double*)calloc(lta_len, sizeof(double));
+    if (!z_ring) {
+        free(r->trace);
+        r->trace = NULL;
+        return 0;
+    }
+    
+    // STA/LTA classico: somme in float, stesse operazioni di sta_lta_scan
+    float sta_sum = 0.0f, lta_sum = 0.0f;
+    // Ricorsivo: medie esponenziali dell'energia (prima somma LTA)
+    double c_sta = 1.0 / sta_len, c_lta = 1.0 / lta_len;
+    double rec_sta = 0.0, rec_lta = 0.0;
+    // Energia sulla finestra STA e sua media/varianza sulla finestra LTA
+    KahanSum e_sum = {0}, z_s1 = {0}, z_s2 = {0};
+    int z_pos = 0, z_count = 0;
+    // Somme di potenze per la kurtosis
+    KahanSum k1 = {0}, k2 = {0}, k3 = {0}, k4 = {0};
+    // Tutte compensate: ogni campione del segnale si legge una volta
+    // entrando e una uscendo dalla finestra, costo fisso per campione
+    
+    for (int i = warmup; i < n; i++) {
+        float x = signal[i];
+        float a = fabsf(x);
+        double xd = x, e = xd * xd;
+        
+        // --- Classico (finestre piene da first in poi) ---
+        if (i <= first) {
+            lta_sum += a;
+            if (i >= first - sta_len + 1) sta_sum += a;
+        } else {
+            sta_sum += a - fabsf(signal[i - sta_len]);
+            lta_sum += a - fabsf(signal[i - lta_len]);
+        }
+        
+        // --- Energia STA (condivisa da ricorsivo e Z) ---
+        kahan_add(&e_sum, e);
+        if (i - sta_len >= warmup) {
+            double old = signal[i - sta_len];
+            kahan_add(&e_sum, -(old * old));
+        }
+        if (i < first) {
+            rec_lta += e;
+        } else if (i == first) {
+            // Medie ricorsive avviate dalle finestre piene
+            rec_lta = (rec_lta + e) / lta_len;
+            rec_sta = e_sum.sum / sta_len;
+        } else {
+            rec_sta += c_sta * (e - rec_sta);
+            rec_lta += c_lta * (e - rec_lta);
+        }
+        
+        // --- Potenze su finestra kurtosis ---
+        kahan_add(&k1, xd); kahan_add(&k2, e);
+        kahan_add(&k3, e * xd); kahan_add(&k4, e * e);
+        if (i - kurt_len >= warmup) {
+            double old = signal[i - kurt_len];
+            double old2 = old * old;
+            kahan_add(&k1, -old); kahan_add(&k2, -old2);
+            kahan_add(&k3, -(old2 * old)); kahan_add(&k4, -(old2 * old2));
+        }
+        
+        // Z: energia STA rispetto alle lta_len precedenti
+        double sta_e = e_sum.sum / sta_len;
+        float z = 0.0f;
+        if (i >= warmup + sta_len - 1) {
+            if (z_count == lta_len) {
+                double mean = z_s1.sum / lta_len;
+                double var = z_s2.sum / lta_len - mean * mean;
+                if (var > 0.0) z = (float)((sta_e - mean) / sqrt(var));
+                double old = z_ring[z_pos];
+                kahan_add(&z_s1, -old);
+                kahan_add(&z_s2, -(old * old));
+            } else {
+                z_count++;
+            }
+            z_ring[z_pos] = sta_e;
+            kahan_add(&z_s1, sta_e);
+            kahan_add(&z_s2, sta_e * sta_e);
+            if (++z_pos == lta_len) z_pos = 0;
+        }
+        
+        if (i < first) continue;
+        
+        float sta_avg = sta_sum / sta_len;
+        float lta_avg = lta_sum / lta_len;
+        float classic = (lta_avg > 1e-9f) ? sta_avg / lta_avg : 0.0f;
+        float recursive = (rec_lta > 1e-18) ? (float)(rec_sta / rec_lta) : 0.0f;
+        
+        float kurt = 0.0f;
+        if (i >= warmup + kurt_len - 1) {
+            double m = k1.sum / kurt_len;
+            double m2 = k2.sum / kurt_len - m * m;
+            double m4 = k4.sum / kurt_len - 4.0 * m * k3.sum / kurt_len +
+                        6.0 * m * m * k2.sum / kurt_len - 3.0 * m * m * m * m;
+            if (m2 > 0.0) kurt = (float)(m4 / (m2 * m2) - 3.0);
+        }
+        
+        float values[DETECTOR_COUNT] = {classic, recursive, z, kurt};
+        for (int d = 0; d < DETECTOR_COUNT; d++) {
+            bank_record(r, d, i, values[d], bank->threshold[d]);
+        }
+        if (r->trace) {
+            float *row = r->trace + (size_t)(i - first) * DETECTOR_COUNT;
+            for (int d = 0; d < DETECTOR_COUNT; d++) row[d] = values[d];
+        }
+    }
+    
+    free(z_ring);
+    return 1;
+}
+
+void free_trigger_bank(TriggerBankResult *r) {
+    free(r->trace);
+    r->trace = NULL;
+}
@@ -6,8 +6,73 @@
 // Inizializza parametri trigger
 void init_trigger_params(TriggerParams *params, float sta_s, float lta_s);
 
+// Stato STA/LTA incrementale (stesse operazioni di find_trigger)
+typedef struct {
+    int sta_len, lta_len;
+    int start_idx;        // Primo indice con finestre complete
+    float sta_sum, lta_sum;
+} StaLtaScan;
+
+// Lunghezze finestre e primo indice valido
+void sta_lta_init(StaLtaScan *scan, TriggerParams *params,
+                  FilterConfig *filter_cfg);
+
+// Somme iniziali su [start_idx - lta_len + 1, start_idx];
+// signal[j] è il campione origin + j
+void sta_lta_prime(StaLtaScan *scan, const float *signal, int origin);
+
+// Scansione degli indici [from, to), ritorna 1 al primo superamento
+// (indice e rapporto in params, nessun output)
+int sta_lta_scan(StaLtaScan *scan, const float *signal, int origin,
+                 int from, int to, TriggerParams *params);
+
 // Cerca trigger STA/LTA
 int find_trigger(float *signal, int n, TriggerParams *params, 
                  FilterConfig *filter_cfg);
 
+// Messaggio di trigger (indice, tempo, rapporto), fuori dal loop di scansione
+void report_trigger(const TriggerParams *params, const FilterConfig *filter_cfg);
+
+// ---- Banco di rivelatori ----
+
+typedef enum {
+    DETECTOR_STA_LTA,     // STA/LTA classico su |x| (lo stesso del trigger)
+    DETECTOR_RECURSIVE,   // STA/LTA ricorsivo sull'energia x²
+    DETECTOR_Z,           // Energia STA standardizzata sulla finestra LTA
+    DETECTOR_KURTOSIS,    // Kurtosis in eccesso su finestra mobile
+    DETECTOR_COUNT
+} DetectorType;
+
+typedef struct {
+    float sta_s, lta_s;                 // Finestre comuni (s)
+    float kurt_s;                       // Finestra kurtosis (s)
+    float threshold[DETECTOR_COUNT];
+} TriggerBankParams;
+
+typedef struct {
+    int first;                          // Primo indice valutato
+    int n;
+    int pick_idx[DETECTOR_COUNT];       // Primo superamento, -1 se nessuno
+    float pick_value[DETECTOR_COUNT];
+    int max_idx[DETECTOR_COUNT];
+    float max_value[DETECTOR_COUNT];
+    float *trace;                       // [i - first][rivelatore], NULL = no
+} TriggerBankResult;
+
+// Finestre del trigger e soglie di default (config.h)
+void init_trigger_bank_params(TriggerBankParams *bank,
+                              const TriggerParams *trigger);
+
+// Tutti i rivelatori in un solo passaggio su signal (acc_fir), con somme
+// mobili condivise. Con keep_trace salva le funzioni caratteristiche
+int run_trigger_bank(const float *signal, int n, const FilterConfig *filter_cfg,
+                     const TriggerBankParams *bank, TriggerBankResult *result,
+                     int keep_trace);
+
+// Libera la traccia
+void free_trigger_bank(TriggerBankResult *result);
+
+// Nome breve del rivelatore
+const char* detector_name(DetectorType det);
+
 #endif
\ No newline at end of file
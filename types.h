@@ -1,6 +1,8 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <stddef.h>
+
 typedef enum {
     RC_LOW_RISE, 
     RC_MID_RISE,
@@ -31,14 +33,41 @@ typedef struct {
     float *vel_filt;      // Velocità filtrata
     float *disp;          // Spostamento
     int n_samples;
+    float acc_scale;      // Fattore verso m/s² ancora da applicare ad acc
+    int acc_mapped;       // acc punta a memoria esterna (file mappato)
+    int capacity;         // Campioni allocati per array
+    void *arena;          // Blocco unico con tutti gli array
+    size_t arena_bytes;
+    int arena_huge;       // Arena su huge page (MAP_HUGETLB)
 } SignalData;
 
+typedef enum {
+    FIR_MODE_EXACT,       // Convoluzione con kernel gaussiano completo
+    FIR_MODE_RECURSIVE    // Approssimazione ricorsiva (Deriche)
+} FirMode;
+
+typedef struct {
+    float b0[2], b1[2];   // Numeratori delle due sezioni: b0 + b1 z^-1
+    float a1[2], a2[2];   // Denominatori: 1 + a1 z^-1 + a2 z^-2
+    float gain;           // Normalizzazione guadagno DC
+    int delay;            // Ritardo del picco (filter_len - 1)
+    int settle;           // Campioni di assestamento per i blocchi
+    float error_bound;    // max|y_iir - y_fir| / max|x|
+} RecursiveGaussian;
+
 typedef struct {
     int fs;               // Frequenza campionamento
     float dt;             // Intervallo temporale
     float hp_a, hp_b;     // Coefficienti HP filter
     int filter_len;       // Lunghezza kernel
     float *kernel;        // Kernel FIR
+    int kernel_offset;    // Primo tap non trascurabile
+    int kernel_eff_len;   // Taps effettivi (kernel_offset .. filter_len-1)
+    float prune_tol;      // Energia scartata massima (frazione)
+    float group_delay;    // Ritardo di gruppo del kernel (campioni)
+    int fir_warmup;       // Primo indice con uscita FIR valida
+    FirMode fir_mode;     // Kernel esatto o ricorsivo
+    RecursiveGaussian rg; // Coefficienti modalità ricorsiva
 } FilterConfig;
 
 typedef struct {
@@ -47,6 +76,7 @@ typedef struct {
     float threshold;      // Soglia STA/LTA
     int trigger_idx;      // Indice trigger
     int triggered;        // Flag trigger
+    float trigger_ratio;  // STA/LTA al trigger
 } TriggerParams;
 
 typedef struct {
@@ -0,0 +1,238 @@
+#include "waveform.h"
+#include "io.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static int host_is_little_endian(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t*)&probe == 1;
+}
+
+static uint64_t get_le(const uint8_t *p, int bytes) {
+    uint64_t v = 0;
+    for (int b = bytes - 1; b >= 0; b--) v = (v << 8) | p[b];
+    return v;
+}
+
+static void put_le(uint8_t *p, uint64_t v, int bytes) {
+    for (int b = 0; b < bytes; b++) {
+        p[b] = (uint8_t)(v & 0xff);
+        v >>= 8;
+    }
+}
+
+// Header serializzato campo per campo (indipendente da padding e endianness)
+static void decode_header(const uint8_t *raw, WaveformHeader *hdr) {
+    memcpy(hdr->magic, raw, 4);
+    hdr->version = (uint16_t)get_le(raw + 4, 2);
+    hdr->unit = (uint16_t)get_le(raw + 6, 2);
+    hdr->fs = (uint32_t)get_le(raw + 8, 4);
+    hdr->n_channels = (uint32_t)get_le(raw + 12, 4);
+    hdr->n_samples = get_le(raw + 16, 8);
+    uint64_t t = get_le(raw + 24, 8);
+    memcpy(&hdr->start_time, &t, sizeof(double));
+    hdr->data_offset = get_le(raw + 32, 8);
+    memcpy(hdr->reserved, raw + 40, sizeof(hdr->reserved));
+}
+
+static void encode_header(const WaveformHeader *hdr, uint8_t *raw) {
+    memset(raw, 0, 64);
+    memcpy(raw, hdr->magic, 4);
+    put_le(raw + 4, hdr->version, 2);
+    put_le(raw + 6, hdr->unit, 2);
+    put_le(raw + 8, hdr->fs, 4);
+    put_le(raw + 12, hdr->n_channels, 4);
+    put_le(raw + 16, hdr->n_samples, 8);
+    uint64_t t;
+    memcpy(&t, &hdr->start_time, sizeof(double));
+    put_le(raw + 24, t, 8);
+    put_le(raw + 32, hdr->data_offset, 8);
+    memcpy(raw + 40, hdr->reserved, sizeof(hdr->reserved));
+}
+
+int waveform_open(WaveformFile *wf, const char *filename) {
+    memset(wf, 0, sizeof(*wf));
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("ERRORE: Impossibile aprire %s\n", filename);
+        return 0;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 64) {
+        printf("ERRORE: %s non è un file .dwsf valido\n", filename);
+        close(fd);
+        return 0;
+    }
+
+    wf->map_len = (size_t)st.st_size;
+    wf->map = mmap(NULL, wf->map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (wf->map == MAP_FAILED) {
+        wf->map = NULL;
+        printf("ERRORE: mmap fallita su %s\n", filename);
+        return 0;
+    }
+
+    decode_header((const uint8_t*)wf->map, &wf->hdr);
+    WaveformHeader *h = &wf->hdr;
+
+    // Dimensioni verificate per divisione: nessun prodotto che trabocca
+    if (memcmp(h->magic, WAVEFORM_MAGIC, 4) != 0 || h->version != WAVEFORM_VERSION ||
+        h->n_channels == 0 || h->data_offset < 64 ||
+        h->data_offset % WAVEFORM_ALIGN != 0 || h->data_offset > wf->map_len ||
+        h->n_samples > (wf->map_len - h->data_offset) /
+                       ((uint64_t)h->n_channels * sizeof(float))) {
+        printf("ERRORE: header .dwsf non valido in %s\n", filename);
+        waveform_close(wf);
+        return 0;
+    }
+
+    // Lettura sequenziale: anticipa il caricamento delle pagine
+    madvise(wf->map, wf->map_len, MADV_SEQUENTIAL);
+    madvise(wf->map, wf->map_len, MADV_WILLNEED);
+
+    // Solo su host big-endian serve una copia convertita
+    if (!host_is_little_endian()) {
+        size_t count = (size_t)h->n_channels * h->n_samples;
+        wf->swapped = (float*)malloc(count * sizeof(float));
+        if (!wf->swapped) {
+            waveform_close(wf);
+            return 0;
+        }
+        const uint8_t *src = (const uint8_t*)wf->map + h->data_offset;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t v = (uint32_t)get_le(src + 4 * i, 4);
+            memcpy(&wf->swapped[i], &v, sizeof(float));
+        }
+    }
+    return 1;
+}
+
+const float* waveform_channel(const WaveformFile *wf, int channel) {
+    if (channel < 0 || (uint32_t)channel >= wf->hdr.n_channels) return NULL;
+    size_t offset = (size_t)channel * wf->hdr.n_samples;
+    if (wf->swapped) return wf->swapped + offset;
+    return (const float*)((const uint8_t*)wf->map + wf->hdr.data_offset) + offset;
+}
+
+float waveform_unit_scale(const WaveformFile *wf) {
+    return (wf->hdr.unit == WAVEFORM_UNIT_G) ? G_TO_MS2 : 1.0f;
+}
+
+uint64_t waveform_tag(const WaveformFile *wf) {
+    return get_le(wf->hdr.reserved, 8);
+}
+
+void waveform_close(WaveformFile *wf) {
+    if (wf->map) munmap(wf->map, wf->map_len);
+    free(wf->swapped);
+    wf->map = NULL;
+    wf->swapped = NULL;
+}
+
+int waveform_write(const char *filename, int fs, int unit, double start_time,
+                   const float *const *channels, int n_channels,
+                   long n_samples) {
+    return waveform_write_tagged(filename, fs, unit, start_time, channels,
+                                 n_channels, n_samples, 0);
+}
+
+int waveform_write_tagged(const char *filename, int fs, int unit,
+                          double start_time, const float *const *channels,
+                          int n_channels, long n_samples, uint64_t tag) {
+    FILE *fp = fopen(filename, "wb");
+    if (!fp) {
+        printf("ERRORE: Impossibile creare %s\n", filename);
+        return 0;
+    }
+
+    WaveformHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, WAVEFORM_MAGIC, 4);
+    hdr.version = WAVEFORM_VERSION;
+    hdr.unit = (uint16_t)unit;
+    hdr.fs = (uint32_t)fs;
+    hdr.n_channels = (uint32_t)n_channels;
+    hdr.n_samples = (uint64_t)n_samples;
+    hdr.start_time = start_time;
+    hdr.data_offset = WAVEFORM_ALIGN;
+    put_le(hdr.reserved, tag, 8);
+
+    uint8_t raw[WAVEFORM_ALIGN];
+    encode_header(&hdr, raw);
+    int ok = fwrite(raw, 1, sizeof(raw), fp) == sizeof(raw);
+
+    int little = host_is_little_endian();
+    for (int c = 0; c < n_channels && ok; c++) {
+        if (little) {
+            ok = fwrite(channels[c], sizeof(float), n_samples, fp) == (size_t)n_samples;
+            continue;
+        }
+        for (long i = 0; i < n_samples && ok; i++) {
+            uint32_t v;
+            uint8_t le[4];
+            memcpy(&v, &channels[c][i], sizeof(float));
+            put_le(le, v, 4);
+            ok = fwrite(le, 1, 4, fp) == 4;
+        }
+    }
+
+    if (fclose(fp) != 0) ok = 0;
+    if (!ok) printf("ERRORE: Scrittura fallita su %s\n", filename);
+    return ok;
+}
+
+int waveform_convert_text(const char *out_file, int fs, int unit,
+                          double start_time, const char *const *in_files,
+                          int n_files) {
+    float **channels = (float**)calloc(n_files, sizeof(float*));
+    long n = -1;
+    int ok = channels != NULL;
+
+    for (int c = 0; c < n_files && ok; c++) {
+        channels[c] = (float*)malloc(MAX_SAMPLES * sizeof(float));
+        if (!channels[c]) {
+            ok = 0;
+            break;
+        }
+        // Valori salvati nell'unità originale, dichiarata nell'header
+        int count = read_acceleration_file(in_files[c], channels[c],
+                                           MAX_SAMPLES, 1.0f);
+        if (count < 0) {
+            ok = 0;
+            break;
+        }
+        if (n >= 0 && count != n) {
+            printf("⚠ ATTENZIONE: %s ha %d campioni (attesi %ld), troncato\n",
+                   in_files[c], count, n);
+        }
+        if (n < 0 || count < n) n = count;
+    }
+
+    if (ok) {
+        ok = waveform_write(out_file, fs, unit, start_time,
+                            (const float *const*)channels, n_files, n);
+    }
+    if (ok) {
+        printf("✓ Convertito: %s (%d canali, %ld campioni, %d Hz, %s)\n",
+               out_file, n_files, n, fs,
+               unit == WAVEFORM_UNIT_G ? "g" : "m/s²");
+    }
+
+    for (int c = 0; c < n_files && channels; c++) free(channels[c]);
+    free(channels);
+    return ok;
+}
+
+int waveform_is_binary_name(const char *filename) {
+    size_t len = strlen(filename);
+    return len > 5 && strcmp(filename + len - 5, ".dwsf") == 0;
+}
@@ -0,0 +1,70 @@
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Formato binario DOSEWS (.dwsf), tutto little-endian:
+//   header da 64 byte, poi n_channels blocchi contigui di n_samples
+//   float32, a partire da data_offset (allineato a 64 byte); i primi 8
+//   byte riservati sono un'etichetta libera (0 = nessuna)
+#define WAVEFORM_MAGIC "DWSF"
+#define WAVEFORM_VERSION 1
+#define WAVEFORM_ALIGN 64
+
+#define WAVEFORM_UNIT_MS2 0   // m/s²
+#define WAVEFORM_UNIT_G   1   // g
+
+typedef struct {
+    char magic[4];            // "DWSF"
+    uint16_t version;
+    uint16_t unit;            // WAVEFORM_UNIT_*
+    uint32_t fs;              // Frequenza campionamento (Hz)
+    uint32_t n_channels;
+    uint64_t n_samples;       // Campioni per canale
+    double start_time;        // Inizio registrazione (s epoch UTC, 0 = ignoto)
+    uint64_t data_offset;     // Offset dati in byte
+    uint8_t reserved[24];     // Etichetta (8 byte) e spazio libero
+} WaveformHeader;
+
+typedef struct {
+    WaveformHeader hdr;
+    void *map;                // Mappatura del file
+    size_t map_len;
+    float *swapped;           // Copia convertita solo su host big-endian
+} WaveformFile;
+
+// Apre e mappa un file .dwsf (nessuna copia su host little-endian)
+int waveform_open(WaveformFile *wf, const char *filename);
+
+// Puntatore ai campioni del canale (unità del file)
+const float* waveform_channel(const WaveformFile *wf, int channel);
+
+// Fattore verso m/s² per l'unità del file
+float waveform_unit_scale(const WaveformFile *wf);
+
+// Etichetta dell'header (chiave della cache filtri, 0 = nessuna)
+uint64_t waveform_tag(const WaveformFile *wf);
+
+// Chiude il file
+void waveform_close(WaveformFile *wf);
+
+// Scrive un file .dwsf da canali in memoria
+int waveform_write(const char *filename, int fs, int unit, double start_time,
+                   const float *const *channels, int n_channels,
+                   long n_samples);
+
+// Come waveform_write, con etichetta nell'header
+int waveform_write_tagged(const char *filename, int fs, int unit,
+                          double start_time, const float *const *channels,
+                          int n_channels, long n_samples, uint64_t tag);
+
+// Converte file di testo (uno per canale) in un unico .dwsf
+int waveform_convert_text(const char *out_file, int fs, int unit,
+                          double start_time, const char *const *in_files,
+                          int n_files);
+
+// Vero se il nome file ha estensione .dwsf
+int waveform_is_binary_name(const char *filename);
+
+#endif